@@ -6,7 +6,16 @@
 #include <CommonLibHeader.h>
 
 #include "TTLToolsCircBuf.h"
+#include "TTLToolsCompactBuf.h"
+#include "TTLToolsTripleBuf.h"
 #include "TTLToolsLogic.h"
 #include "TTLToolsCondition.h"
+#include "TTLToolsOffline.h"
+#include "TTLToolsSynth.h"
+#include "TTLToolsSharedMem.h"
+#include "TTLToolsPSTH.h"
+#include "TTLToolsStats.h"
+#include "TTLToolsSequence.h"
+#include "TTLToolsProfile.h"
 
 #endif
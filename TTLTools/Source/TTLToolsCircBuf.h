@@ -22,7 +22,11 @@ namespace TTLTools
 		void enqueue(datatype_t newVal);
 		datatype_t dequeue();
 		datatype_t snoop();
+		datatype_t snoopAt(size_t offset);
+		datatype_t snoopNewest();
+		void discardNewest();
 		size_t count();
+		size_t capacity();
 
 	protected:
 		datatype_t dataBuffer[bufsize];
@@ -104,6 +108,46 @@ datatype_t TTLTools::CircBuf<datatype_t,bufsize>::snoop()
 }
 
 
+template <class datatype_t,size_t bufsize>
+datatype_t TTLTools::CircBuf<datatype_t,bufsize>::snoopAt(size_t offset)
+{
+	// Pick a safe default value.
+	datatype_t returnVal = (datatype_t) 0;
+
+	// Non-destructive read of the Nth-oldest element. Offset 0 is the same as snoop().
+	if (offset < dataCount)
+		returnVal = dataBuffer[(readPtr + offset) % bufsize];
+
+	return returnVal;
+}
+
+
+template <class datatype_t,size_t bufsize>
+datatype_t TTLTools::CircBuf<datatype_t,bufsize>::snoopNewest()
+{
+	// Pick a safe default value.
+	datatype_t returnVal = (datatype_t) 0;
+
+	// Non-destructive read of the most recently enqueued element.
+	if (dataCount > 0)
+		returnVal = dataBuffer[(writePtr + bufsize - 1) % bufsize];
+
+	return returnVal;
+}
+
+
+template <class datatype_t,size_t bufsize>
+void TTLTools::CircBuf<datatype_t,bufsize>::discardNewest()
+{
+	// Un-enqueue the most recently enqueued element.
+	if (dataCount > 0)
+	{
+		writePtr = (writePtr + bufsize - 1) % bufsize;
+		dataCount--;
+	}
+}
+
+
 template <class datatype_t,size_t bufsize>
 size_t TTLTools::CircBuf<datatype_t,bufsize>::count()
 {
@@ -111,6 +155,13 @@ size_t TTLTools::CircBuf<datatype_t,bufsize>::count()
 }
 
 
+template <class datatype_t,size_t bufsize>
+size_t TTLTools::CircBuf<datatype_t,bufsize>::capacity()
+{
+	return bufsize;
+}
+
+
 #endif
 
 //
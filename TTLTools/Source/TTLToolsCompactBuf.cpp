@@ -0,0 +1,297 @@
+#include "TTLTools.h"
+#define LOGICDEBUGPREFIX "[TTLToolsCompact] "
+#include "TTLToolsDebug.h"
+
+using namespace TTLTools;
+
+// Private constants.
+
+// Worst-case encoded sizes: a 64-bit varint is at most 10 bytes, and the level/tag field is at most 5 bytes.
+#define COMPACT_MAX_RECORD_BYTES 15
+
+
+// Private helper functions.
+
+// Zig-zag encoding maps small negative numbers to small positive numbers.
+
+static inline uint64 compactZigZag(int64 thisVal)
+{
+    return (((uint64) thisVal) << 1) ^ ((uint64) (thisVal >> 63));
+}
+
+
+static inline int64 compactUnZigZag(uint64 thisVal)
+{
+    return (int64) ( (thisVal >> 1) ^ (~(thisVal & 1) + 1) );
+}
+
+
+// This writes a varint to a scratch buffer, returning the number of bytes written.
+static inline size_t compactWriteVarint(uint8 *dest, uint64 thisVal)
+{
+    size_t byteCount = 0;
+
+    while (thisVal >= 0x80)
+    {
+        dest[byteCount] = (uint8) ((thisVal & 0x7f) | 0x80);
+        thisVal >>= 7;
+        byteCount++;
+    }
+
+    dest[byteCount] = (uint8) thisVal;
+    byteCount++;
+
+    return byteCount;
+}
+
+
+
+//
+// Compact TTL event buffer.
+
+
+// Constructor.
+CompactEventBuf::CompactEventBuf()
+{
+    byteCapacity = 0;
+    clear();
+}
+
+
+// Setup. This discards buffered events.
+void CompactEventBuf::setCapacity(size_t byteCount)
+{
+    // A record must never fill the entire buffer, or we can't tell its length from the read and write pointers.
+    if ( (byteCount > 0) && (byteCount <= COMPACT_MAX_RECORD_BYTES) )
+        byteCount = COMPACT_MAX_RECORD_BYTES + 1;
+
+    byteBuffer.clear();
+    if (byteCount > 0)
+        byteBuffer.insertMultiple(0, 0, (int) byteCount);
+
+    byteCapacity = byteCount;
+    clear();
+}
+
+
+size_t CompactEventBuf::getCapacity()
+{
+    return byteCapacity;
+}
+
+
+// Buffer manipulation.
+
+void CompactEventBuf::clear()
+{
+    readPtr = 0;
+    writePtr = 0;
+    byteCount = 0;
+    eventCount = 0;
+
+    lastWrittenTime = 0;
+    lastReadTime = 0;
+
+    headTime = 0;
+    headLevel = false;
+    headTag = 0;
+    headBytes = 0;
+
+    tailValid = false;
+    tailTime = 0;
+    tailLevel = false;
+    tailTag = 0;
+    tailStartPtr = 0;
+    tailBytes = 0;
+    tailPrevWrittenTime = 0;
+}
+
+
+// This returns false (discarding the event) if there isn't space for it.
+bool CompactEventBuf::enqueue(int64 newTime, bool newLevel, int newTag)
+{
+    uint8 scratch[COMPACT_MAX_RECORD_BYTES];
+    size_t recordBytes = 0;
+
+    // Level goes in the low bit of the tag field, so that untagged events take one byte.
+    recordBytes += compactWriteVarint(scratch, (compactZigZag(newTag) << 1) | (newLevel ? 1 : 0));
+    recordBytes += compactWriteVarint(scratch + recordBytes, compactZigZag(newTime - lastWrittenTime));
+
+    if ((byteCount + recordBytes) > byteCapacity)
+        return false;
+
+    tailValid = true;
+    tailTime = newTime;
+    tailLevel = newLevel;
+    tailTag = newTag;
+    tailStartPtr = writePtr;
+    tailBytes = recordBytes;
+    tailPrevWrittenTime = lastWrittenTime;
+
+    uint8 *bufPtr = byteBuffer.getRawDataPointer();
+    for (size_t bIdx = 0; bIdx < recordBytes; bIdx++)
+    {
+        bufPtr[writePtr] = scratch[bIdx];
+        writePtr++;
+        if (writePtr >= byteCapacity)
+            writePtr = 0;
+    }
+
+    byteCount += recordBytes;
+    eventCount++;
+    lastWrittenTime = newTime;
+
+    // If this is the only event, it's also the head event.
+    if (1 == eventCount)
+        decodeHead();
+
+    return true;
+}
+
+
+void CompactEventBuf::dequeue()
+{
+    if (eventCount > 0)
+    {
+        readPtr = (readPtr + headBytes) % byteCapacity;
+        byteCount -= headBytes;
+        eventCount--;
+        lastReadTime = headTime;
+
+        if (eventCount > 0)
+            decodeHead();
+        else
+            tailValid = false;
+    }
+}
+
+
+// Non-destructive reads of the oldest event.
+
+int64 CompactEventBuf::snoopTime()
+{
+    return ( (eventCount > 0) ? headTime : 0 );
+}
+
+
+bool CompactEventBuf::snoopLevel()
+{
+    return ( (eventCount > 0) ? headLevel : false );
+}
+
+
+int CompactEventBuf::snoopTag()
+{
+    return ( (eventCount > 0) ? headTag : 0 );
+}
+
+
+// Non-destructive read of the second-oldest event. This returns false if there isn't one.
+bool CompactEventBuf::snoopSecond(int64 &secondTime, bool &secondLevel, int &secondTag)
+{
+    if (eventCount < 2)
+        return false;
+
+    size_t bytePtr = (readPtr + headBytes) % byteCapacity;
+    decodeRecord(bytePtr, headTime, secondTime, secondLevel, secondTag);
+
+    return true;
+}
+
+
+// Access to the most recently enqueued event.
+
+bool CompactEventBuf::snoopNewest(int64 &newestTime, bool &newestLevel, int &newestTag)
+{
+    if ( (eventCount < 1) || (!tailValid) )
+        return false;
+
+    newestTime = tailTime;
+    newestLevel = tailLevel;
+    newestTag = tailTag;
+
+    return true;
+}
+
+
+// Only one event can be un-enqueued before the next enqueue, since record boundaries can't be found by scanning backwards.
+bool CompactEventBuf::discardNewest()
+{
+    if ( (eventCount < 1) || (!tailValid) )
+        return false;
+
+    // If the buffer is emptied, the restored "last written" time is also the last time read, so delta bases stay consistent.
+    writePtr = tailStartPtr;
+    byteCount -= tailBytes;
+    eventCount--;
+    lastWrittenTime = tailPrevWrittenTime;
+    tailValid = false;
+
+    return true;
+}
+
+
+size_t CompactEventBuf::count()
+{
+    return eventCount;
+}
+
+
+size_t CompactEventBuf::bytesUsed()
+{
+    return byteCount;
+}
+
+
+// Protected accessors.
+
+// This decodes the oldest record into the "head" cache.
+void CompactEventBuf::decodeHead()
+{
+    size_t bytePtr = readPtr;
+
+    decodeRecord(bytePtr, lastReadTime, headTime, headLevel, headTag);
+
+    // setCapacity() guarantees that a record is always shorter than the buffer, so this can't wrap to zero.
+    headBytes = (bytePtr + byteCapacity - readPtr) % byteCapacity;
+}
+
+
+// This decodes the record at the specified position, and advances the position past it.
+// Timestamps are relative to the previous record's timestamp.
+void CompactEventBuf::decodeRecord(size_t &bytePtr, int64 baseTime, int64 &thisTime, bool &thisLevel, int &thisTag)
+{
+    uint64 levelTag = readVarint(bytePtr);
+    uint64 timeDelta = readVarint(bytePtr);
+
+    thisLevel = (0 != (levelTag & 1));
+    thisTag = (int) compactUnZigZag(levelTag >> 1);
+    thisTime = baseTime + compactUnZigZag(timeDelta);
+}
+
+
+// This reads a varint starting at the specified position, and advances the position past it.
+uint64 CompactEventBuf::readVarint(size_t &bytePtr)
+{
+    uint8 *bufPtr = byteBuffer.getRawDataPointer();
+    uint64 result = 0;
+    int shift = 0;
+    bool moreBytes = true;
+
+    while (moreBytes && (shift < 64))
+    {
+        uint8 thisByte = bufPtr[bytePtr];
+        bytePtr++;
+        if (bytePtr >= byteCapacity)
+            bytePtr = 0;
+
+        result |= ((uint64) (thisByte & 0x7f)) << shift;
+        shift += 7;
+        moreBytes = (0 != (thisByte & 0x80));
+    }
+
+    return result;
+}
+
+
+// This is the end of the file.
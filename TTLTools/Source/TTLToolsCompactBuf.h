@@ -0,0 +1,86 @@
+#ifndef TTLTOOLS_COMPACTBUF_H_DEFINED
+#define TTLTOOLS_COMPACTBUF_H_DEFINED
+
+// This is intended to be included via "TTLTools.h", rather than included manually.
+
+
+//
+// Compact TTL event buffer - Declaration.
+
+// This is a circular byte buffer holding delta-encoded TTL events.
+// Timestamps are stored as variable-length deltas from the previous event, and level and tag are packed into a single
+// variable-length field. Typical TTL traffic takes 2-4 bytes per event instead of 13.
+// Storage is allocated by setCapacity(), which should be called during setup rather than during processing.
+
+// NOTE - This is not MT-safe, for the same reasons as CircBuf.
+
+namespace TTLTools
+{
+	class COMMON_LIB CompactEventBuf
+	{
+	public:
+		// Constructor.
+		CompactEventBuf();
+		// Default destructor is fine.
+
+		// Setup. This discards buffered events.
+		// A capacity of zero frees the storage.
+		void setCapacity(size_t byteCount);
+		size_t getCapacity();
+
+		// Buffer manipulation.
+		void clear();
+		// This returns false (discarding the event) if there isn't space for it.
+		bool enqueue(int64 newTime, bool newLevel, int newTag);
+		void dequeue();
+
+		// Non-destructive reads of the oldest event. These return safe values (0 or false) if the buffer is empty.
+		int64 snoopTime();
+		bool snoopLevel();
+		int snoopTag();
+
+		// Non-destructive read of the second-oldest event. This returns false if there isn't one.
+		bool snoopSecond(int64 &secondTime, bool &secondLevel, int &secondTag);
+
+		// Access to the most recently enqueued event. Only one event can be un-enqueued before the next enqueue,
+		// since record boundaries can't be found by scanning backwards. These return false if that isn't possible.
+		bool snoopNewest(int64 &newestTime, bool &newestLevel, int &newestTag);
+		bool discardNewest();
+
+		size_t count();
+		size_t bytesUsed();
+
+	protected:
+		Array<uint8> byteBuffer;
+		size_t byteCapacity;
+		size_t readPtr, writePtr, byteCount, eventCount;
+
+		// Delta encoding bases.
+		int64 lastWrittenTime;
+		int64 lastReadTime;
+
+		// Decoded copy of the oldest event, so that snooping is cheap.
+		int64 headTime;
+		bool headLevel;
+		int headTag;
+		size_t headBytes;
+
+		// Copy of the most recently enqueued event, so that it can be un-enqueued.
+		bool tailValid;
+		int64 tailTime;
+		bool tailLevel;
+		int tailTag;
+		size_t tailStartPtr;
+		size_t tailBytes;
+		int64 tailPrevWrittenTime;
+
+		void decodeHead();
+		void decodeRecord(size_t &bytePtr, int64 baseTime, int64 &thisTime, bool &thisLevel, int &thisTag);
+		uint64 readVarint(size_t &bytePtr);
+	};
+}
+
+#endif
+
+
+// This is the end of the file.
@@ -3,6 +3,9 @@
 #define LOGICDEBUGIDVARIABLE debugID
 #include "TTLToolsDebug.h"
 
+#include <vector>
+#include <algorithm>
+
 using namespace TTLTools;
 
 // Private constants.
@@ -10,6 +13,14 @@ using namespace TTLTools;
 // This timestamp could happen, but we need _something_ as the default.
 #define LOGIC_TIMESTAMP_BOGUS (-1)
 
+// Checkpoint section marker. This catches attempts to restore state saved by a different class.
+#define LOGIC_STATE_MAGIC_CONDITION 0x444e4f43
+#define LOGIC_STATE_MAGIC_EDGEFRONT 0x544e5246
+#define LOGIC_STATE_MAGIC_CONDBACKEND 0x4b434142
+
+// Feature index for specialized trigger checking that never asserts (for out-of-range feature types).
+#define LOGIC_FEATURE_NONE 4
+
 
 //
 // Configuration for processing conditions on one signal.
@@ -40,6 +51,7 @@ void ConditionConfig::clear()
     deglitchSamps = 0;
 
     outputActiveHigh = true;
+    allowOverlap = false;
 }
 
 
@@ -69,9 +81,18 @@ void ConditionConfig::forceSanity()
     if (delayMaxSamps < delayMinSamps)
         delayMaxSamps = delayMinSamps;
 
-    // Re-trigger interval has to be at least (delay + sustain) to avoid overlapping pulses.
-    if (deadTimeSamps < (delayMaxSamps + sustainSamps))
-        deadTimeSamps = delayMaxSamps + sustainSamps;
+    if (allowOverlap)
+    {
+        // Overlapping pulses get merged, but we still need some dead time to avoid re-triggering forever at one timestamp.
+        if (deadTimeSamps < 1)
+            deadTimeSamps = 1;
+    }
+    else
+    {
+        // Re-trigger interval has to be at least (delay + sustain) to avoid overlapping pulses.
+        if (deadTimeSamps < (delayMaxSamps + sustainSamps))
+            deadTimeSamps = delayMaxSamps + sustainSamps;
+    }
 }
 
 
@@ -83,8 +104,11 @@ void ConditionConfig::forceSanity()
 // Constructor.
 ConditionProcessor::ConditionProcessor()
 {
+    frontEnd = NULL;
+
     // The constructor should already have done this, but do it anyways.
     config.clear();
+    selectTriggerCheckers();
 
     // Initialize. Use a dummy timestamp and input level.
     setPrevInput(LOGIC_TIMESTAMP_BOGUS, false);
@@ -93,11 +117,21 @@ ConditionProcessor::ConditionProcessor()
 }
 
 
+// Destructor.
+ConditionProcessor::~ConditionProcessor()
+{
+    if (NULL != frontEnd)
+        frontEnd->removeBackEnd(this);
+}
+
+
 // Configuration accessors.
 
 void ConditionProcessor::setConfig(ConditionConfig &newConfig)
 {
     config = newConfig;
+    matchFrontEndDeglitch(config);
+    selectTriggerCheckers();
     clearBuffer();
     resetTrigger();
 }
@@ -109,10 +143,152 @@ ConditionConfig ConditionProcessor::getConfig()
 }
 
 
+// Lock-free configuration request. This is safe to call from one thread other than the processing thread.
+void ConditionProcessor::requestConfig(const ConditionConfig &newConfig)
+{
+    ConditionConfig &slotConfig = pendingConfig.getWriteSlot();
+
+    slotConfig = newConfig;
+    slotConfig.forceSanity();
+
+    pendingConfig.publish();
+}
+
+
+// This applies the most recently requested configuration, if there is one. This returns true if the configuration changed.
+// This is called at the start of advanceToTime(), so most callers don't need to call it directly.
+bool ConditionProcessor::applyPendingConfig()
+{
+    if (!pendingConfig.fetchLatest())
+        return false;
+
+    applyConfigLive(pendingConfig.getReadSlot());
+    return true;
+}
+
+
+// Configuration change that keeps queued output and carries trigger state forward.
+void ConditionProcessor::applyConfigLive(const ConditionConfig &newConfig)
+{
+    ConditionConfig oldConfig = config;
+    int64 oldStableTime = nextStableTime;
+    int64 oldReadyTime = nextReadyTime;
+
+    ConditionConfig saneConfig = newConfig;
+    saneConfig.forceSanity();
+    matchFrontEndDeglitch(saneConfig);
+
+    // Everything up to here has already been checked for triggers, and output up to the watermark may have been
+    // passed downstream. New triggers can't be back-dated into that interval.
+    int64 firstOpenTime = getWatermark();
+    if (prevInputTime > firstOpenTime)
+        firstOpenTime = prevInputTime;
+    firstOpenTime++;
+
+    // Scheduled edges get their polarity when they're released, and pulses that have already started have to end the
+    // way they started. On a polarity change, release all of them under the old polarity, then switch the idle level
+    // after the last one. New pulses can't start until after that.
+    int64 polarityChangeTime = LOGIC_TIMESTAMP_BOGUS;
+    if (saneConfig.outputActiveHigh != oldConfig.outputActiveHigh)
+    {
+        polarityChangeTime = firstOpenTime;
+
+        int64 lastEdgeTime = LOGIC_TIMESTAMP_BOGUS;
+        for (int edgeIdx = 0; edgeIdx < scheduledCount; edgeIdx++)
+            if (scheduledTimes[edgeIdx] > lastEdgeTime)
+                lastEdgeTime = scheduledTimes[edgeIdx];
+        releaseScheduledOutput(lastEdgeTime);
+
+        // The idle-level change gets its own timestamp, so that it isn't merged with the last trailing edge.
+        if (lastEdgeTime >= polarityChangeTime)
+            polarityChangeTime = lastEdgeTime + 1;
+
+        // Without overlap, pulses are queued directly (and may already have been read), so they aren't in the schedule.
+        // The last one ends no later than the last trigger plus the longest delay and sustain.
+        if (LOGIC_TIMESTAMP_BOGUS != nextReadyTime)
+        {
+            int64 lastPulseEnd = nextReadyTime - oldConfig.deadTimeSamps + oldConfig.delayMaxSamps + oldConfig.sustainSamps;
+            if (lastPulseEnd >= polarityChangeTime)
+                polarityChangeTime = lastPulseEnd + 1;
+        }
+
+        enqueueOutputUnchecked(polarityChangeTime, !(saneConfig.outputActiveHigh), 0);
+    }
+
+    config = saneConfig;
+    selectTriggerCheckers();
+
+    // Stable time is tied to the most recent edge. If we were still waiting for it, keep waiting, but not in the past.
+    if (LOGIC_TIMESTAMP_BOGUS != nextStableTime)
+    {
+        bool wasPending = (nextStableTime >= firstOpenTime);
+        nextStableTime += config.deglitchSamps - oldConfig.deglitchSamps;
+        if (wasPending && (nextStableTime < firstOpenTime))
+            nextStableTime = firstOpenTime;
+    }
+
+    // Ready time is tied to the most recent trigger. As with stable time, if we were still waiting for it, keep waiting.
+    if (LOGIC_TIMESTAMP_BOGUS != nextReadyTime)
+    {
+        bool wasPending = (nextReadyTime >= firstOpenTime);
+
+        int64 lastTriggerTime = nextReadyTime - oldConfig.deadTimeSamps;
+        nextReadyTime = lastTriggerTime + config.deadTimeSamps;
+
+        // The last pulse may still be queued. Unless pulses can overlap, new pulses can't start until it has ended.
+        int64 lastPulseEnd = lastTriggerTime + oldConfig.delayMaxSamps + oldConfig.sustainSamps;
+        if ( (!(config.allowOverlap && oldConfig.allowOverlap)) && (nextReadyTime < (lastPulseEnd - config.delayMinSamps)) )
+            nextReadyTime = lastPulseEnd - config.delayMinSamps;
+
+        if (wasPending && (nextReadyTime < firstOpenTime))
+            nextReadyTime = firstOpenTime;
+    }
+
+    // If the input was already stable, a trigger would be timed from the ready time. Moving either time can leave that
+    // in the checked interval without having triggered there, so it moves up too. Triggers timed from a pending stable
+    // time are fine, since the delay is at least the deglitch interval.
+    if ( ((nextStableTime != oldStableTime) || (nextReadyTime != oldReadyTime))
+        && (nextStableTime < firstOpenTime) && (nextReadyTime < firstOpenTime) )
+        nextReadyTime = firstOpenTime;
+
+    // With a different feature, conditions that didn't trigger before might trigger now. They can only do that from here on.
+    // A primed edge trigger only means something for the feature it was primed for.
+    if (config.desiredFeature != oldConfig.desiredFeature)
+    {
+        if (nextReadyTime < firstOpenTime)
+            nextReadyTime = firstOpenTime;
+        edgeTriggerPrimed = false;
+    }
+
+    // After a polarity change, the earliest new pulse has to start after the idle level changed.
+    if ( (LOGIC_TIMESTAMP_BOGUS != polarityChangeTime) && (nextReadyTime <= (polarityChangeTime - config.delayMinSamps)) )
+        nextReadyTime = polarityChangeTime - config.delayMinSamps + 1;
+}
+
+
+// The front-end's stable times assume its own deglitch interval, and we use ours to find trigger times, so they have to match.
+// NOTE - This is called on the processing thread (when the configuration is set or applied), not from requestConfig().
+void ConditionProcessor::matchFrontEndDeglitch(ConditionConfig &thisConfig)
+{
+    if (NULL == frontEnd)
+        return;
+
+    int64 wantDeglitch = frontEnd->getDeglitchSamps();
+    if (thisConfig.deglitchSamps == wantDeglitch)
+        return;
+
+    L_WARN(".. WARNING - Back-end deglitch (" << thisConfig.deglitchSamps << ") doesn't match front-end (" << wantDeglitch << "); using the front-end's.");
+
+    thisConfig.deglitchSamps = wantDeglitch;
+    thisConfig.forceSanity();
+}
+
+
 // Buffer reset. This clears queued output and sets past output to the "not asserted" level.
 void ConditionProcessor::clearBuffer()
 {
     LogicFIFO::clearBuffer();
+    clearSchedule();
 
     // Adjust idle output to reflect configuration.
     prevAcknowledgedLevel = !(config.outputActiveHigh);
@@ -144,25 +320,258 @@ void ConditionProcessor::handleInput(int64 inputTime, bool inputLevel, int input
     checkPhantomEventsUntil(inputTime);
     checkForTrigger(inputTime, inputLevel);
 
+    // Triggers detected at or after a given time always produce output at or after that time (delay >= deglitch).
+    // More input may arrive at inputTime, so output is final up to just before it.
+    releaseScheduledOutput(inputTime - 1);
+    advanceWatermark(inputTime - 1);
+
 #endif
 }
 
 
+// Batch input. This is handleInput() for each event, with the watermark only updated at the end.
+void ConditionProcessor::handleInputBatch(const LogicEvent *inputEvents, int eventCount)
+{
+#if LOGICDEBUG_BYPASSCONDITION
+    copyInputBatch(inputEvents, eventCount);
+#else
+
+    for (int evIdx = 0; evIdx < eventCount; evIdx++)
+    {
+        int64 thisTime = inputEvents[evIdx].time;
+
+        checkPhantomEventsUntil(thisTime);
+        checkForTrigger(thisTime, inputEvents[evIdx].level);
+        releaseScheduledOutput(thisTime - 1);
+    }
+
+    if (eventCount > 0)
+        advanceWatermark(inputEvents[eventCount - 1].time - 1);
+
+#endif
+}
+
+
+// Input processing from a shared front-end. Edge detection and stable time tracking were already done by the front-end.
+// NOTE - The front-end's deglitch interval has to match ours, since we use it to find the trigger time.
+void ConditionProcessor::handleFrontEndInput(int64 inputTime, bool inputLevel, bool haveRising, bool haveFalling, int64 stableTime)
+{
+    checkPhantomEventsUntil(inputTime);
+
+    if (haveRising || haveFalling)
+    {
+        nextStableTime = stableTime;
+        checkForTriggerWithEdges(inputTime, inputLevel, haveRising, haveFalling);
+        timesValid = true;
+    }
+    else
+        checkForTriggerWithEdges(inputTime, inputLevel, false, false);
+
+    releaseScheduledOutput(inputTime - 1);
+    advanceWatermark(inputTime - 1);
+}
+
+
 // Input processing. This advances the internal time to the specified timestamp.
 void ConditionProcessor::advanceToTime(int64 newTime)
 {
+    advanceToTimeBudgeted(newTime, 0, 0);
+}
+
+
+// Budgeted advance. This stops early between phantom events, and returns the time reached.
+int64 ConditionProcessor::advanceToTimeBudgeted(int64 newTime, int maxEvents, int64 deadlineTicks)
+{
+    // This is the block boundary; pick up any configuration change requested since the last one.
+    applyPendingConfig();
+
 #if LOGICDEBUG_BYPASSCONDITION
-    // Do nothing; we're a FIFO for testing purposes.
+    // Act like a FIFO for testing purposes.
+    LogicFIFO::advanceToTime(newTime);
+    return newTime;
 #else
-    checkPhantomEventsUntil(newTime);
+    int64 reachedTime = newTime;
+
+    // If we stopped early, everything up to the last phantom event checked is done, and the next one is after it.
+    if (!checkPhantomEventsUntil(newTime, maxEvents, deadlineTicks))
+    {
+        reachedTime = prevInputTime;
+        if (reachedTime < getWatermark())
+            reachedTime = getWatermark();
+    }
+
+    releaseScheduledOutput(reachedTime);
+    advanceWatermark(reachedTime);
+
+    return reachedTime;
 #endif
 }
 
 
+// Checkpointing. Child class state goes ahead of the parent's, so that it can be validated before anything is overwritten.
+void ConditionProcessor::writeState(MemoryOutputStream &dest)
+{
+    dest.writeInt(LOGIC_STATE_MAGIC_CONDITION);
+
+    dest.writeInt((int) config.desiredFeature);
+    dest.writeInt64(config.delayMinSamps);
+    dest.writeInt64(config.delayMaxSamps);
+    dest.writeInt64(config.sustainSamps);
+    dest.writeInt64(config.deadTimeSamps);
+    dest.writeInt64(config.deglitchSamps);
+    dest.writeBool(config.outputActiveHigh);
+    dest.writeBool(config.allowOverlap);
+
+    dest.writeInt64(rng.getSeed());
+
+    dest.writeInt64(nextStableTime);
+    dest.writeInt64(nextReadyTime);
+    dest.writeBool(edgeTriggerPrimed);
+    dest.writeBool(timesValid);
+
+    // Scheduled edges are stored in heap order, so they can be restored as-is.
+    dest.writeInt(activePulseCount);
+    dest.writeInt(scheduledCount);
+    for (int edgeIdx = 0; edgeIdx < scheduledCount; edgeIdx++)
+    {
+        dest.writeInt64(scheduledTimes[edgeIdx]);
+        dest.writeInt(scheduledDeltas[edgeIdx]);
+    }
+
+    LogicFIFO::writeState(dest);
+}
+
+
+bool ConditionProcessor::readState(MemoryInputStream &source)
+{
+    // Magic number, feature, five delays, two flags, the seed, two times, two flags, and two schedule counts.
+    if (source.getNumBytesRemaining() < (4 + 4 + 5*8 + 2 + 8 + 2*8 + 2 + 2*4))
+        return false;
+    if (LOGIC_STATE_MAGIC_CONDITION != source.readInt())
+        return false;
+
+    ConditionConfig newConfig;
+    newConfig.desiredFeature = (ConditionConfig::FeatureType) source.readInt();
+    newConfig.delayMinSamps = source.readInt64();
+    newConfig.delayMaxSamps = source.readInt64();
+    newConfig.sustainSamps = source.readInt64();
+    newConfig.deadTimeSamps = source.readInt64();
+    newConfig.deglitchSamps = source.readInt64();
+    newConfig.outputActiveHigh = source.readBool();
+    newConfig.allowOverlap = source.readBool();
+
+    int64 newSeed = source.readInt64();
+
+    int64 newStableTime = source.readInt64();
+    int64 newReadyTime = source.readInt64();
+    bool newPrimed = source.readBool();
+    bool newValid = source.readBool();
+
+    int newActiveCount = source.readInt();
+    int newScheduledCount = source.readInt();
+    if ( (newScheduledCount < 0) || (newScheduledCount > TTLTOOLSCOND_SCHEDULE_SIZE)
+        || (source.getNumBytesRemaining() < (8 + 4) * (int64) newScheduledCount) )
+        return false;
+
+    // Stage the schedule, so that a failed restore doesn't overwrite anything.
+    Array<int64> newTimes;
+    Array<int> newDeltas;
+    for (int edgeIdx = 0; edgeIdx < newScheduledCount; edgeIdx++)
+    {
+        newTimes.add(source.readInt64());
+        newDeltas.add(source.readInt());
+    }
+
+    if (!LogicFIFO::readState(source))
+        return false;
+
+    scheduledCount = newScheduledCount;
+    activePulseCount = newActiveCount;
+    for (int edgeIdx = 0; edgeIdx < scheduledCount; edgeIdx++)
+    {
+        scheduledTimes[edgeIdx] = newTimes[edgeIdx];
+        scheduledDeltas[edgeIdx] = newDeltas[edgeIdx];
+    }
+
+    // Don't call setConfig(); that would discard the state we just restored.
+    config = newConfig;
+    selectTriggerCheckers();
+    rng.setSeed(newSeed);
+
+    nextStableTime = newStableTime;
+    nextReadyTime = newReadyTime;
+    edgeTriggerPrimed = newPrimed;
+    timesValid = newValid;
+
+    return true;
+}
+
+
+// This returns true if the other processor would produce the same output as this one from here on, given the same input.
+bool ConditionProcessor::matchesTriggerState(ConditionProcessor &other)
+{
+    bool isMatch = true;
+
+    isMatch = isMatch && (nextStableTime == other.nextStableTime);
+
+    // A ready time that's already passed, and that's before the most recent edge, has no further effect.
+    // Processors that started at different points usually disagree about exactly when that was.
+    bool ourReadySpent = (nextReadyTime <= prevInputTime) && (nextReadyTime <= (nextStableTime - config.deglitchSamps));
+    bool otherReadySpent = (other.nextReadyTime <= other.prevInputTime)
+        && (other.nextReadyTime <= (other.nextStableTime - other.config.deglitchSamps));
+    if (!(ourReadySpent && otherReadySpent))
+        isMatch = isMatch && (nextReadyTime == other.nextReadyTime);
+
+    isMatch = isMatch && (edgeTriggerPrimed == other.edgeTriggerPrimed) && (timesValid == other.timesValid);
+    isMatch = isMatch && (prevInputTime == other.prevInputTime) && (prevInputLevel == other.prevInputLevel);
+    // Random number generator state only matters if delays vary.
+    if (config.delayMaxSamps != config.delayMinSamps)
+        isMatch = isMatch && (rng.getSeed() == other.rng.getSeed());
+    isMatch = isMatch && (activePulseCount == other.activePulseCount) && (scheduledCount == other.scheduledCount);
+
+    // The schedules may be in different heap orders, so compare sorted copies.
+    if (isMatch && (scheduledCount > 0))
+    {
+        std::vector< std::pair<int64, int> > ourEdges, otherEdges;
+        for (int edgeIdx = 0; edgeIdx < scheduledCount; edgeIdx++)
+        {
+            ourEdges.push_back(std::make_pair(scheduledTimes[edgeIdx], scheduledDeltas[edgeIdx]));
+            otherEdges.push_back(std::make_pair(other.scheduledTimes[edgeIdx], other.scheduledDeltas[edgeIdx]));
+        }
+        std::sort(ourEdges.begin(), ourEdges.end());
+        std::sort(otherEdges.begin(), otherEdges.end());
+        isMatch = (ourEdges == otherEdges);
+    }
+
+    return isMatch;
+}
+
+
 // This checks to see if trigger conditions are met and enqueues an output pulse if so.
 // The idea is to call this for both real and phantom events.
 // This returns true if "nextStableTime" or "nextReadyTime" changed.
+// This calls the variant specialized for the current configuration.
 bool ConditionProcessor::checkForTrigger(int64 thisTime, bool thisLevel)
+{
+    return (this->*triggerChecker)(thisTime, thisLevel);
+}
+
+
+// This is the part of checkForTrigger() that happens after edge detection and stable time tracking.
+// Shared front-ends do edge detection once and call this directly.
+// This returns true if "nextReadyTime" changed.
+bool ConditionProcessor::checkForTriggerWithEdges(int64 thisTime, bool thisLevel, bool haveRising, bool haveFalling)
+{
+    return (this->*edgeTriggerChecker)(thisTime, thisLevel, haveRising, haveFalling);
+}
+
+
+// Specialized trigger checking. There's one variant for each feature type, and for zero or nonzero deglitch time and
+// delay jitter, so the per-event path doesn't test configuration values and skips arithmetic that would do nothing.
+// "featureType" is a ConditionConfig::FeatureType value, or LOGIC_FEATURE_NONE for out-of-range values.
+
+template <int featureType, bool haveDeglitch, bool haveJitter>
+bool ConditionProcessor::checkForTriggerSpecialized(int64 thisTime, bool thisLevel)
 {
     bool hadTimeChange = false;
 
@@ -174,10 +583,29 @@ bool ConditionProcessor::checkForTrigger(int64 thisTime, bool thisLevel)
     // This pushes the stable time forward.
     if (haveRising || haveFalling)
     {
-        nextStableTime = thisTime + config.deglitchSamps;
+        nextStableTime = thisTime;
+        if (haveDeglitch)
+            nextStableTime += config.deglitchSamps;
         hadTimeChange = true;
     }
 
+    if (checkForTriggerWithEdgesSpecialized<featureType, haveDeglitch, haveJitter>(thisTime, thisLevel, haveRising, haveFalling))
+        hadTimeChange = true;
+
+    if (hadTimeChange)
+        timesValid = true;
+
+    return hadTimeChange;
+}
+
+
+template <int featureType, bool haveDeglitch, bool haveJitter>
+bool ConditionProcessor::checkForTriggerWithEdgesSpecialized(int64 thisTime, bool thisLevel, bool haveRising, bool haveFalling)
+{
+    const bool isEdgeFeature = ( (ConditionConfig::edgeRising == featureType) || (ConditionConfig::edgeFalling == featureType) );
+
+    bool hadTimeChange = false;
+
     // Figure out if the signal is stable and if we're still in dead time.
     bool isStable = ( thisTime >= nextStableTime );
     bool isReady = ( thisTime >= nextReadyTime );
@@ -187,13 +615,8 @@ bool ConditionProcessor::checkForTrigger(int64 thisTime, bool thisLevel)
 
     // If we saw an edge outside of deadtime, and want that edge, record it.
     // Seeing the wrong type of edge un-primes the trigger. We should have responded to it by now if it was stable for long enough.
-    if (isReady && (haveRising || haveFalling))
-    {
-        if (ConditionConfig::edgeRising == config.desiredFeature)
-            edgeTriggerPrimed = haveRising;
-        else if (ConditionConfig::edgeFalling == config.desiredFeature)
-            edgeTriggerPrimed = haveFalling;
-    }
+    if (isEdgeFeature && isReady && (haveRising || haveFalling))
+        edgeTriggerPrimed = (ConditionConfig::edgeRising == featureType) ? haveRising : haveFalling;
 
 // FIXME - Diagnostics. Very spammy!
 //L_PRINT( "Input " << (thisLevel ? "high" : "low") << " at " << thisTime << " rise: " << (haveRising ? "Y" : "n") << "  fall: " << (haveFalling ? "Y" : "n") << "  Stable: " << (isStable ? "Y" : "n") << "  Rdy: " << (isReady ? "Y" : "n") );
@@ -202,21 +625,14 @@ bool ConditionProcessor::checkForTrigger(int64 thisTime, bool thisLevel)
     if (isStable && isReady)
     {
         bool wantAssert = false;
-        switch (config.desiredFeature)
-        {
-        case ConditionConfig::levelHigh:
+        if (ConditionConfig::levelHigh == featureType)
             wantAssert = thisLevel;
-            break;
-        case ConditionConfig::levelLow:
+        else if (ConditionConfig::levelLow == featureType)
             wantAssert = !thisLevel;
-            break;
-        case ConditionConfig::edgeRising:
-        case ConditionConfig::edgeFalling:
+        else if (isEdgeFeature)
+        {
             wantAssert = edgeTriggerPrimed;
             edgeTriggerPrimed = false;
-            break;
-        default:
-            break;
         }
 
         if (wantAssert)
@@ -225,7 +641,9 @@ bool ConditionProcessor::checkForTrigger(int64 thisTime, bool thisLevel)
 
             // Figure out when the trigger actually was.
             // Stable time is tied to the most recent edge seen. If we had an edge trigger primed, the trigger was the most recent edge.
-            int64 triggerTime = nextStableTime - config.deglitchSamps;
+            int64 triggerTime = nextStableTime;
+            if (haveDeglitch)
+                triggerTime -= config.deglitchSamps;
             // This only happens for level triggers. Edge trigger asserts can only generate from edges that are in the ready period.
             if (triggerTime < nextReadyTime)
                 triggerTime = nextReadyTime;
@@ -233,26 +651,36 @@ bool ConditionProcessor::checkForTrigger(int64 thisTime, bool thisLevel)
             // Avoid generating warnings on startup. We still want warnings if a bug causes time travel, so check the initialization flag.
             if (!timesValid)
             {
-                int64 earliestTime = thisTime - config.deglitchSamps;
+                int64 earliestTime = thisTime;
+                if (haveDeglitch)
+                    earliestTime -= config.deglitchSamps;
                 if (triggerTime < earliestTime)
                     triggerTime = earliestTime;
             }
 
             nextReadyTime = triggerTime + config.deadTimeSamps;
+            // With overlap, dead time can be shorter than the deglitch interval, so a back-dated trigger can leave the
+            // ready time at or before the time we checked. Phantom checks treat that as already checked, so re-triggering
+            // would wait for the next input. Level triggers re-trigger from the next sample instead.
+            if ( (!isEdgeFeature) && (nextReadyTime <= thisTime) )
+                nextReadyTime = thisTime + 1;
             hadTimeChange = true;
 
-            int64 thisDelay = rng.nextInt64();
-            // Avoid taking the modulo of a negative number, since some implementations give a negative result for that.
-            if (thisDelay < 0)
-                thisDelay = -(thisDelay + 1);
-            thisDelay %= (1 + config.delayMaxSamps - config.delayMinSamps);
-            thisDelay += config.delayMinSamps;
+            int64 thisDelay = config.delayMinSamps;
+            if (haveJitter)
+            {
+                int64 thisJitter = rng.nextInt64();
+                // Avoid taking the modulo of a negative number, since some implementations give a negative result for that.
+                if (thisJitter < 0)
+                    thisJitter = -(thisJitter + 1);
+                thisJitter %= (1 + config.delayMaxSamps - config.delayMinSamps);
+                thisDelay += thisJitter;
+            }
 
 // FIXME - Diagnostics. Still spammy.
 L_PRINT("Pulsing " << (config.outputActiveHigh ? "high" : "low") << " from " << (triggerTime + thisDelay) << " to " << (triggerTime + thisDelay + config.sustainSamps) << " (trigger " << triggerTime << ", now " << thisTime << ").");
 
-            enqueueOutput(triggerTime + thisDelay, config.outputActiveHigh, 0);
-            enqueueOutput(triggerTime + thisDelay + config.sustainSamps, !(config.outputActiveHigh), 0);
+            schedulePulse(triggerTime + thisDelay, triggerTime + thisDelay + config.sustainSamps);
         }
     }
 
@@ -263,9 +691,60 @@ L_PRINT("Pulsing " << (config.outputActiveHigh ? "high" : "low") << " from " <<
 }
 
 
+// Table of specialized variants, indexed by [feature][deglitch][jitter].
+#define COND_SPECIALIZED_ROW(feature) \
+    { { &ConditionProcessor::checkForTriggerSpecialized<feature, false, false>, &ConditionProcessor::checkForTriggerSpecialized<feature, false, true> }, \
+      { &ConditionProcessor::checkForTriggerSpecialized<feature, true, false>, &ConditionProcessor::checkForTriggerSpecialized<feature, true, true> } }
+#define COND_SPECIALIZED_EDGE_ROW(feature) \
+    { { &ConditionProcessor::checkForTriggerWithEdgesSpecialized<feature, false, false>, &ConditionProcessor::checkForTriggerWithEdgesSpecialized<feature, false, true> }, \
+      { &ConditionProcessor::checkForTriggerWithEdgesSpecialized<feature, true, false>, &ConditionProcessor::checkForTriggerWithEdgesSpecialized<feature, true, true> } }
+
+// This picks the trigger-checking variants matching the current configuration.
+// This has to be called whenever "config" changes.
+void ConditionProcessor::selectTriggerCheckers()
+{
+    static const TriggerCheckFunc checkerTable[LOGIC_FEATURE_NONE + 1][2][2] =
+    {
+        COND_SPECIALIZED_ROW(ConditionConfig::levelHigh),
+        COND_SPECIALIZED_ROW(ConditionConfig::levelLow),
+        COND_SPECIALIZED_ROW(ConditionConfig::edgeRising),
+        COND_SPECIALIZED_ROW(ConditionConfig::edgeFalling),
+        COND_SPECIALIZED_ROW(LOGIC_FEATURE_NONE)
+    };
+
+    static const EdgeTriggerCheckFunc edgeCheckerTable[LOGIC_FEATURE_NONE + 1][2][2] =
+    {
+        COND_SPECIALIZED_EDGE_ROW(ConditionConfig::levelHigh),
+        COND_SPECIALIZED_EDGE_ROW(ConditionConfig::levelLow),
+        COND_SPECIALIZED_EDGE_ROW(ConditionConfig::edgeRising),
+        COND_SPECIALIZED_EDGE_ROW(ConditionConfig::edgeFalling),
+        COND_SPECIALIZED_EDGE_ROW(LOGIC_FEATURE_NONE)
+    };
+
+    // setConfig() doesn't force sanity, so the feature might be out of range. That never triggers.
+    int featureIdx = (int) config.desiredFeature;
+    if ( (featureIdx < 0) || (featureIdx >= LOGIC_FEATURE_NONE) )
+        featureIdx = LOGIC_FEATURE_NONE;
+
+    int deglitchIdx = (0 != config.deglitchSamps) ? 1 : 0;
+    int jitterIdx = (config.delayMaxSamps != config.delayMinSamps) ? 1 : 0;
+
+    triggerChecker = checkerTable[featureIdx][deglitchIdx][jitterIdx];
+    edgeTriggerChecker = edgeCheckerTable[featureIdx][deglitchIdx][jitterIdx];
+}
+
+#undef COND_SPECIALIZED_ROW
+#undef COND_SPECIALIZED_EDGE_ROW
+
+
 // This checks for phantom events (becoming stable, becoming ready) up to the specified time.
-void ConditionProcessor::checkPhantomEventsUntil(int64 newTime)
+// With a work budget, this returns false if it stopped early.
+bool ConditionProcessor::checkPhantomEventsUntil(int64 newTime, int maxEvents, int64 deadlineTicks)
 {
+    L_PROFILE_SCOPE(profileConditionPhantom)
+
+    WorkBudget budget(maxEvents, deadlineTicks);
+
     // Outside of the ready period, ignore "becoming stable" events.
     // Inside of the ready period, check for them.
     // Becoming stable can only happen once, but re-triggering can happen repeatedly.
@@ -275,6 +754,13 @@ void ConditionProcessor::checkPhantomEventsUntil(int64 newTime)
     // We need to be both ready and stable for anything to happen.
     while ( hadChange && (nextReadyTime <= newTime) && (nextStableTime <= newTime) )
     {
+        // Each check handles everything up to "prevInputTime", and any remaining phantom events are after it.
+        if (budget.isExhausted())
+            return false;
+        budget.countEvent();
+
+        L_PROFILE_EVENTS(profileConditionPhantom, 1)
+
         // There are 6 permutations of the ordering of "became stable", "became ready", and "previous time checked".
         // xxP -> already checked; nothing to do.
         // xxR -> only became ready now; check ready.
@@ -292,9 +778,682 @@ void ConditionProcessor::checkPhantomEventsUntil(int64 newTime)
                 hadChange = checkForTrigger(nextStableTime, prevInputLevel);
         }
         else
+        {
             // Check "ready". Becoming stable before becoming ready still only triggers when ready.
-            hadChange = checkForTrigger(nextReadyTime, prevInputLevel);
+            // Keep going even if this didn't trigger; in the "PRS" case, "stable" still has to be checked.
+            // This always moves "prevInputTime" forwards, so the loop still terminates.
+            checkForTrigger(nextReadyTime, prevInputLevel);
+            hadChange = true;
+        }
     }
+
+    return true;
+}
+
+
+
+// Output scheduling.
+
+void ConditionProcessor::clearSchedule()
+{
+    scheduledCount = 0;
+    activePulseCount = 0;
+}
+
+
+// This schedules one output pulse.
+void ConditionProcessor::schedulePulse(int64 startTime, int64 endTime)
+{
+    // Without overlap, pulses are already in order. Anything still scheduled from before a configuration change goes first.
+    if ( (!config.allowOverlap) && (0 == scheduledCount) )
+    {
+        enqueueOutput(startTime, config.outputActiveHigh, 0);
+        enqueueOutput(endTime, !(config.outputActiveHigh), 0);
+        return;
+    }
+
+    // If there isn't room for both edges, drop the pulse, and report it like any other overload.
+    if ((scheduledCount + 2) > TTLTOOLSCOND_SCHEDULE_SIZE)
+    {
+        overloadCount++;
+        if (1 == overloadCount)
+        {
+            L_WARN(".. WARNING - Output schedule full; pulse at time " << startTime << " dropped.");
+        }
+        return;
+    }
+
+    pushScheduledEdge(startTime, 1);
+    pushScheduledEdge(endTime, -1);
+}
+
+
+// Binary min-heap insertion, ordered by time.
+void ConditionProcessor::pushScheduledEdge(int64 edgeTime, int edgeDelta)
+{
+    int thisIdx = scheduledCount;
+    scheduledCount++;
+
+    while (thisIdx > 0)
+    {
+        int parentIdx = (thisIdx - 1) / 2;
+        if (scheduledTimes[parentIdx] <= edgeTime)
+            break;
+
+        scheduledTimes[thisIdx] = scheduledTimes[parentIdx];
+        scheduledDeltas[thisIdx] = scheduledDeltas[parentIdx];
+        thisIdx = parentIdx;
+    }
+
+    scheduledTimes[thisIdx] = edgeTime;
+    scheduledDeltas[thisIdx] = edgeDelta;
+}
+
+
+// Binary min-heap removal of the earliest edge.
+void ConditionProcessor::popScheduledEdge()
+{
+    if (scheduledCount < 1)
+        return;
+
+    scheduledCount--;
+    int64 movedTime = scheduledTimes[scheduledCount];
+    int movedDelta = scheduledDeltas[scheduledCount];
+
+    int thisIdx = 0;
+    while (true)
+    {
+        int childIdx = (2 * thisIdx) + 1;
+        if (childIdx >= scheduledCount)
+            break;
+        if ( ((childIdx + 1) < scheduledCount) && (scheduledTimes[childIdx + 1] < scheduledTimes[childIdx]) )
+            childIdx++;
+        if (movedTime <= scheduledTimes[childIdx])
+            break;
+
+        scheduledTimes[thisIdx] = scheduledTimes[childIdx];
+        scheduledDeltas[thisIdx] = scheduledDeltas[childIdx];
+        thisIdx = childIdx;
+    }
+
+    scheduledTimes[thisIdx] = movedTime;
+    scheduledDeltas[thisIdx] = movedDelta;
+}
+
+
+// This moves scheduled edges up to and including the specified time to the output, merging overlapping pulses.
+// Edges at the same time are applied together, so a pulse that ends when another starts doesn't make a glitch.
+void ConditionProcessor::releaseScheduledOutput(int64 untilTime)
+{
+    while ( (scheduledCount > 0) && (scheduledTimes[0] <= untilTime) )
+    {
+        int64 thisTime = scheduledTimes[0];
+        bool wasActive = (activePulseCount > 0);
+
+        while ( (scheduledCount > 0) && (scheduledTimes[0] == thisTime) )
+        {
+            activePulseCount += scheduledDeltas[0];
+            popScheduledEdge();
+        }
+
+        bool isActive = (activePulseCount > 0);
+        if (isActive != wasActive)
+            enqueueOutputUnchecked(thisTime, (isActive ? config.outputActiveHigh : !(config.outputActiveHigh)), 0);
+    }
+}
+
+
+//
+// Lightweight trigger back-end for an EdgeFrontEnd.
+
+
+// Constructor.
+ConditionBackEnd::ConditionBackEnd()
+{
+    frontEnd = NULL;
+
+    // The constructor should already have done this, but do it anyways.
+    config.clear();
+
+    // Pulses can't overlap, so output is already in order and is usually read every block. A small buffer is enough.
+    setCompactStorage(true, TTLTOOLSCOND_BACKEND_BUF_BYTES);
+
+    // Initialize. Use a dummy timestamp and input level.
+    setPrevInput(LOGIC_TIMESTAMP_BOGUS, false);
+    clearBuffer();
+    resetTrigger();
+}
+
+
+// Destructor.
+ConditionBackEnd::~ConditionBackEnd()
+{
+    if (NULL != frontEnd)
+        frontEnd->removeBackEnd(this);
+}
+
+
+// Configuration accessors.
+
+// Unlike ConditionProcessor::setConfig(), this forces sanity, since pulses are enqueued directly and have to be in order.
+void ConditionBackEnd::setConfig(ConditionConfig &newConfig)
+{
+    config = newConfig;
+
+    if (config.allowOverlap)
+    {
+        L_WARN(".. WARNING - Lightweight back-ends don't support overlapping pulses; overlap disabled.");
+        config.allowOverlap = false;
+    }
+
+    if ( (NULL != frontEnd) && (config.deglitchSamps != frontEnd->getDeglitchSamps()) )
+    {
+        L_WARN(".. WARNING - Back-end deglitch (" << config.deglitchSamps << ") doesn't match front-end (" << frontEnd->getDeglitchSamps() << "); using the front-end's.");
+        config.deglitchSamps = frontEnd->getDeglitchSamps();
+    }
+
+    config.forceSanity();
+
+    clearBuffer();
+    resetTrigger();
+}
+
+
+ConditionConfig ConditionBackEnd::getConfig()
+{
+    return config;
+}
+
+
+// Live deglitch change from the front-end. This is ConditionProcessor::applyConfigLive() for a deglitch-only change.
+// Changing the deglitch interval can also change the minimum delay and the dead time, via forceSanity().
+void ConditionBackEnd::applyDeglitchLive(int64 newDeglitch)
+{
+    ConditionConfig oldConfig = config;
+    int64 oldStableTime = nextStableTime;
+    int64 oldReadyTime = nextReadyTime;
+
+    config.deglitchSamps = newDeglitch;
+    config.forceSanity();
+
+    // Triggers can't be back-dated into the interval that's already been checked.
+    int64 firstOpenTime = getWatermark();
+    if (prevInputTime > firstOpenTime)
+        firstOpenTime = prevInputTime;
+    firstOpenTime++;
+
+    if (LOGIC_TIMESTAMP_BOGUS != nextStableTime)
+    {
+        bool wasPending = (nextStableTime >= firstOpenTime);
+        nextStableTime += config.deglitchSamps - oldConfig.deglitchSamps;
+        if (wasPending && (nextStableTime < firstOpenTime))
+            nextStableTime = firstOpenTime;
+    }
+
+    // New pulses can't start until the last queued one has ended.
+    if (LOGIC_TIMESTAMP_BOGUS != nextReadyTime)
+    {
+        bool wasPending = (nextReadyTime >= firstOpenTime);
+
+        int64 lastTriggerTime = nextReadyTime - oldConfig.deadTimeSamps;
+        nextReadyTime = lastTriggerTime + config.deadTimeSamps;
+
+        int64 lastPulseEnd = lastTriggerTime + oldConfig.delayMaxSamps + oldConfig.sustainSamps;
+        if (nextReadyTime < (lastPulseEnd - config.delayMinSamps))
+            nextReadyTime = lastPulseEnd - config.delayMinSamps;
+
+        if (wasPending && (nextReadyTime < firstOpenTime))
+            nextReadyTime = firstOpenTime;
+    }
+
+    if ( ((nextStableTime != oldStableTime) || (nextReadyTime != oldReadyTime))
+        && (nextStableTime < firstOpenTime) && (nextReadyTime < firstOpenTime) )
+        nextReadyTime = firstOpenTime;
+}
+
+
+// Buffer reset. This clears queued output and sets past output to the "not asserted" level.
+void ConditionBackEnd::clearBuffer()
+{
+    LogicFIFO::clearBuffer();
+
+    // Adjust idle output to reflect configuration.
+    prevAcknowledgedLevel = !(config.outputActiveHigh);
+}
+
+
+// Condition-processing history reset.
+void ConditionBackEnd::resetTrigger()
+{
+    nextStableTime = LOGIC_TIMESTAMP_BOGUS;
+    nextReadyTime = LOGIC_TIMESTAMP_BOGUS;
+    edgeTriggerPrimed = false;
+    timesValid = false;
+}
+
+
+// Direct input processing. This does our own edge detection, for use without a front-end.
+// NOTE - This strips tags, since there isn't a 1:1 mapping between input and output events.
+void ConditionBackEnd::handleInput(int64 inputTime, bool inputLevel, int inputTag)
+{
+    bool haveRising = (inputLevel && (!prevInputLevel));
+    bool haveFalling = ((!inputLevel) && prevInputLevel);
+
+    int64 stableTime = nextStableTime;
+    if (haveRising || haveFalling)
+        stableTime = inputTime + config.deglitchSamps;
+
+    handleFrontEndInput(inputTime, inputLevel, haveRising, haveFalling, stableTime);
+}
+
+
+// Input processing from a shared front-end. Edge detection and stable time tracking were already done by the front-end.
+void ConditionBackEnd::handleFrontEndInput(int64 inputTime, bool inputLevel, bool haveRising, bool haveFalling, int64 stableTime)
+{
+    checkPhantomEventsUntil(inputTime);
+
+    if (haveRising || haveFalling)
+        nextStableTime = stableTime;
+
+    checkForTrigger(inputTime, inputLevel, haveRising, haveFalling);
+
+    if (haveRising || haveFalling)
+        timesValid = true;
+
+    // Pulses are enqueued as soon as they're triggered, and can't start before the input that triggered them.
+    advanceWatermark(inputTime - 1);
+}
+
+
+// Input processing. This advances the internal time to the specified timestamp.
+void ConditionBackEnd::advanceToTime(int64 newTime)
+{
+    checkPhantomEventsUntil(newTime);
+    advanceWatermark(newTime);
+}
+
+
+// Checkpointing. Child class state goes ahead of the parent's, so that it can be validated before anything is overwritten.
+void ConditionBackEnd::writeState(MemoryOutputStream &dest)
+{
+    dest.writeInt(LOGIC_STATE_MAGIC_CONDBACKEND);
+
+    dest.writeInt((int) config.desiredFeature);
+    dest.writeInt64(config.delayMinSamps);
+    dest.writeInt64(config.delayMaxSamps);
+    dest.writeInt64(config.sustainSamps);
+    dest.writeInt64(config.deadTimeSamps);
+    dest.writeInt64(config.deglitchSamps);
+    dest.writeBool(config.outputActiveHigh);
+
+    dest.writeInt64(rng.getSeed());
+
+    dest.writeInt64(nextStableTime);
+    dest.writeInt64(nextReadyTime);
+    dest.writeBool(edgeTriggerPrimed);
+    dest.writeBool(timesValid);
+
+    LogicFIFO::writeState(dest);
+}
+
+
+bool ConditionBackEnd::readState(MemoryInputStream &source)
+{
+    // Magic number, feature, five delays, one flag, the seed, two times, and two flags.
+    if (source.getNumBytesRemaining() < (4 + 4 + 5*8 + 1 + 8 + 2*8 + 2))
+        return false;
+    if (LOGIC_STATE_MAGIC_CONDBACKEND != source.readInt())
+        return false;
+
+    ConditionConfig newConfig;
+    newConfig.desiredFeature = (ConditionConfig::FeatureType) source.readInt();
+    newConfig.delayMinSamps = source.readInt64();
+    newConfig.delayMaxSamps = source.readInt64();
+    newConfig.sustainSamps = source.readInt64();
+    newConfig.deadTimeSamps = source.readInt64();
+    newConfig.deglitchSamps = source.readInt64();
+    newConfig.outputActiveHigh = source.readBool();
+    newConfig.allowOverlap = false;
+
+    int64 newSeed = source.readInt64();
+
+    int64 newStableTime = source.readInt64();
+    int64 newReadyTime = source.readInt64();
+    bool newPrimed = source.readBool();
+    bool newValid = source.readBool();
+
+    if (!LogicFIFO::readState(source))
+        return false;
+
+    // Don't call setConfig(); that would discard the state we just restored.
+    config = newConfig;
+    config.forceSanity();
+    rng.setSeed(newSeed);
+
+    nextStableTime = newStableTime;
+    nextReadyTime = newReadyTime;
+    edgeTriggerPrimed = newPrimed;
+    timesValid = newValid;
+
+    return true;
+}
+
+
+// This checks to see if trigger conditions are met and enqueues an output pulse if so.
+// The idea is to call this for both real and phantom events.
+void ConditionBackEnd::checkForTrigger(int64 thisTime, bool thisLevel, bool haveRising, bool haveFalling)
+{
+    bool isEdgeFeature = ( (ConditionConfig::edgeRising == config.desiredFeature) || (ConditionConfig::edgeFalling == config.desiredFeature) );
+
+    // Figure out if the signal is stable and if we're still in dead time.
+    bool isStable = ( thisTime >= nextStableTime );
+    bool isReady = ( thisTime >= nextReadyTime );
+
+    // Update the "last input seen" record.
+    setPrevInput(thisTime, thisLevel);
+
+    // If we saw an edge outside of deadtime, and want that edge, record it.
+    if (isEdgeFeature && isReady && (haveRising || haveFalling))
+        edgeTriggerPrimed = (ConditionConfig::edgeRising == config.desiredFeature) ? haveRising : haveFalling;
+
+    if (!(isStable && isReady))
+        return;
+
+    bool wantAssert = false;
+    if (ConditionConfig::levelHigh == config.desiredFeature)
+        wantAssert = thisLevel;
+    else if (ConditionConfig::levelLow == config.desiredFeature)
+        wantAssert = !thisLevel;
+    else
+    {
+        wantAssert = edgeTriggerPrimed;
+        edgeTriggerPrimed = false;
+    }
+
+    if (!wantAssert)
+        return;
+
+    // Figure out when the trigger actually was. Stable time is tied to the most recent edge seen.
+    int64 triggerTime = nextStableTime - config.deglitchSamps;
+    // This only happens for level triggers.
+    if (triggerTime < nextReadyTime)
+        triggerTime = nextReadyTime;
+
+    // Avoid generating warnings on startup.
+    if (!timesValid)
+    {
+        int64 earliestTime = thisTime - config.deglitchSamps;
+        if (triggerTime < earliestTime)
+            triggerTime = earliestTime;
+    }
+
+    nextReadyTime = triggerTime + config.deadTimeSamps;
+    timesValid = true;
+
+    int64 thisDelay = config.delayMinSamps;
+    if (config.delayMaxSamps != config.delayMinSamps)
+    {
+        int64 thisJitter = rng.nextInt64();
+        // Avoid taking the modulo of a negative number, since some implementations give a negative result for that.
+        if (thisJitter < 0)
+            thisJitter = -(thisJitter + 1);
+        thisJitter %= (1 + config.delayMaxSamps - config.delayMinSamps);
+        thisDelay += thisJitter;
+    }
+
+    // Dead time is at least (delay + sustain), so pulses are already in order.
+    enqueueOutput(triggerTime + thisDelay, config.outputActiveHigh, 0);
+    enqueueOutput(triggerTime + thisDelay + config.sustainSamps, !(config.outputActiveHigh), 0);
+}
+
+
+// This checks for phantom events (becoming stable, becoming ready) up to the specified time.
+// See ConditionProcessor::checkPhantomEventsUntil() for the case analysis.
+void ConditionBackEnd::checkPhantomEventsUntil(int64 newTime)
+{
+    bool hadChange = true;
+    while ( hadChange && (nextReadyTime <= newTime) && (nextStableTime <= newTime) )
+    {
+        if (nextReadyTime <= prevInputTime)
+        {
+            if (nextStableTime <= prevInputTime)
+                hadChange = false;
+            else
+            {
+                // Checking "stable" only changes anything if it triggers, which moves the ready time.
+                int64 oldReadyTime = nextReadyTime;
+                checkForTrigger(nextStableTime, prevInputLevel, false, false);
+                hadChange = (nextReadyTime != oldReadyTime);
+            }
+        }
+        else
+            checkForTrigger(nextReadyTime, prevInputLevel, false, false);
+    }
+}
+
+
+
+//
+// Shared edge-detection front-end for several condition processors watching one TTL signal.
+
+
+// Constructor.
+EdgeFrontEnd::EdgeFrontEnd()
+{
+    deglitchSamps = 0;
+
+    setPrevInput(LOGIC_TIMESTAMP_BOGUS, false);
+    resetEdgeState();
+}
+
+
+// Destructor.
+EdgeFrontEnd::~EdgeFrontEnd()
+{
+    clearBackEnds();
+}
+
+
+// Configuration.
+
+// This is a live change for the back-ends, which keep their queued output and carry their trigger state forward.
+// Our stable time is tied to the most recent edge, the same way theirs is.
+void EdgeFrontEnd::setDeglitchSamps(int64 newDeglitch)
+{
+    int64 oldDeglitch = deglitchSamps;
+    deglitchSamps = (newDeglitch < 0) ? 0 : newDeglitch;
+
+    if (LOGIC_TIMESTAMP_BOGUS != nextStableTime)
+        nextStableTime += deglitchSamps - oldDeglitch;
+
+    for (int bIdx = 0; bIdx < backEndList.size(); bIdx++)
+    {
+        ConditionConfig backEndConfig = backEndList[bIdx]->getConfig();
+        backEndConfig.deglitchSamps = deglitchSamps;
+        backEndList[bIdx]->applyConfigLive(backEndConfig);
+    }
+
+    for (int bIdx = 0; bIdx < lightBackEndList.size(); bIdx++)
+        lightBackEndList[bIdx]->applyDeglitchLive(deglitchSamps);
+}
+
+
+int64 EdgeFrontEnd::getDeglitchSamps()
+{
+    return deglitchSamps;
+}
+
+
+void EdgeFrontEnd::clearBackEnds()
+{
+    for (int bIdx = 0; bIdx < backEndList.size(); bIdx++)
+        backEndList[bIdx]->frontEnd = NULL;
+    for (int bIdx = 0; bIdx < lightBackEndList.size(); bIdx++)
+        lightBackEndList[bIdx]->frontEnd = NULL;
+
+    backEndList.clear();
+    lightBackEndList.clear();
+}
+
+
+// Back-ends have to use the same deglitch interval as the front-end. Other parameters can differ.
+void EdgeFrontEnd::addBackEnd(ConditionProcessor* newBackEnd)
+{
+    if (NULL == newBackEnd)
+        return;
+
+    if (newBackEnd->getConfig().deglitchSamps != deglitchSamps)
+    {
+        L_WARN(".. WARNING - Front-end back-end deglitch mismatch (" << deglitchSamps << " vs " << newBackEnd->getConfig().deglitchSamps << "); back-end not added.");
+        return;
+    }
+
+    if (this == newBackEnd->frontEnd)
+        return;
+    if (NULL != newBackEnd->frontEnd)
+        newBackEnd->frontEnd->removeBackEnd(newBackEnd);
+
+    newBackEnd->frontEnd = this;
+    backEndList.add(newBackEnd);
+}
+
+
+void EdgeFrontEnd::removeBackEnd(ConditionProcessor* oldBackEnd)
+{
+    if ( (NULL == oldBackEnd) || (this != oldBackEnd->frontEnd) )
+        return;
+
+    oldBackEnd->frontEnd = NULL;
+    backEndList.removeFirstMatchingValue(oldBackEnd);
+}
+
+
+// Lightweight back-ends follow the same rules as full ones.
+void EdgeFrontEnd::addBackEnd(ConditionBackEnd* newBackEnd)
+{
+    if (NULL == newBackEnd)
+        return;
+
+    if (newBackEnd->getConfig().deglitchSamps != deglitchSamps)
+    {
+        L_WARN(".. WARNING - Front-end back-end deglitch mismatch (" << deglitchSamps << " vs " << newBackEnd->getConfig().deglitchSamps << "); back-end not added.");
+        return;
+    }
+
+    if (this == newBackEnd->frontEnd)
+        return;
+    if (NULL != newBackEnd->frontEnd)
+        newBackEnd->frontEnd->removeBackEnd(newBackEnd);
+
+    newBackEnd->frontEnd = this;
+    lightBackEndList.add(newBackEnd);
+}
+
+
+void EdgeFrontEnd::removeBackEnd(ConditionBackEnd* oldBackEnd)
+{
+    if ( (NULL == oldBackEnd) || (this != oldBackEnd->frontEnd) )
+        return;
+
+    oldBackEnd->frontEnd = NULL;
+    lightBackEndList.removeFirstMatchingValue(oldBackEnd);
+}
+
+
+// Accessors.
+
+void EdgeFrontEnd::clearBuffer()
+{
+    LogicFIFO::clearBuffer();
+
+    for (int bIdx = 0; bIdx < backEndList.size(); bIdx++)
+        backEndList[bIdx]->clearBuffer();
+    for (int bIdx = 0; bIdx < lightBackEndList.size(); bIdx++)
+        lightBackEndList[bIdx]->clearBuffer();
+}
+
+
+// Edge-tracking history reset. This also resets back-end trigger state.
+void EdgeFrontEnd::resetEdgeState()
+{
+    nextStableTime = LOGIC_TIMESTAMP_BOGUS;
+
+    for (int bIdx = 0; bIdx < backEndList.size(); bIdx++)
+        backEndList[bIdx]->resetTrigger();
+    for (int bIdx = 0; bIdx < lightBackEndList.size(); bIdx++)
+        lightBackEndList[bIdx]->resetTrigger();
+}
+
+
+// Input processing. This does edge detection and stable time tracking once, and hands the result to every back-end.
+void EdgeFrontEnd::handleInput(int64 inputTime, bool inputLevel, int inputTag)
+{
+    bool haveRising = (inputLevel && (!prevInputLevel));
+    bool haveFalling = ((!inputLevel) && prevInputLevel);
+
+    if (haveRising || haveFalling)
+        nextStableTime = inputTime + deglitchSamps;
+
+    setPrevInput(inputTime, inputLevel);
+
+    // Repeated levels still get forwarded; they move the back-ends' phantom event checkpoints.
+    for (int bIdx = 0; bIdx < backEndList.size(); bIdx++)
+        backEndList[bIdx]->handleFrontEndInput(inputTime, inputLevel, haveRising, haveFalling, nextStableTime);
+    for (int bIdx = 0; bIdx < lightBackEndList.size(); bIdx++)
+        lightBackEndList[bIdx]->handleFrontEndInput(inputTime, inputLevel, haveRising, haveFalling, nextStableTime);
+
+    advanceWatermark(inputTime - 1);
+}
+
+
+void EdgeFrontEnd::handleInputBatch(const LogicEvent *inputEvents, int eventCount)
+{
+    for (int evIdx = 0; evIdx < eventCount; evIdx++)
+        EdgeFrontEnd::handleInput(inputEvents[evIdx].time, inputEvents[evIdx].level, inputEvents[evIdx].tag);
+}
+
+
+// Input processing. This advances the internal time to the specified timestamp, for us and for all back-ends.
+void EdgeFrontEnd::advanceToTime(int64 newTime)
+{
+    for (int bIdx = 0; bIdx < backEndList.size(); bIdx++)
+        backEndList[bIdx]->advanceToTime(newTime);
+    for (int bIdx = 0; bIdx < lightBackEndList.size(); bIdx++)
+        lightBackEndList[bIdx]->advanceToTime(newTime);
+
+    advanceWatermark(newTime);
+}
+
+
+// Checkpointing. Back-ends are checkpointed separately.
+void EdgeFrontEnd::writeState(MemoryOutputStream &dest)
+{
+    dest.writeInt(LOGIC_STATE_MAGIC_EDGEFRONT);
+
+    dest.writeInt64(deglitchSamps);
+    dest.writeInt64(nextStableTime);
+
+    LogicFIFO::writeState(dest);
+}
+
+
+bool EdgeFrontEnd::readState(MemoryInputStream &source)
+{
+    if (source.getNumBytesRemaining() < (4 + 8 + 8))
+        return false;
+    if (LOGIC_STATE_MAGIC_EDGEFRONT != source.readInt())
+        return false;
+
+    int64 newDeglitch = source.readInt64();
+    int64 newStableTime = source.readInt64();
+
+    if (!LogicFIFO::readState(source))
+        return false;
+
+    deglitchSamps = newDeglitch;
+    nextStableTime = newStableTime;
+
+    return true;
 }
 
 
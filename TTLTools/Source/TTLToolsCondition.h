@@ -3,9 +3,20 @@
 
 // This is intended to be included via "TTLTools.h", rather than included manually.
 
+
+// Magic constant: maximum number of scheduled output edges (two per pulse) when overlapping pulses are allowed.
+#define TTLTOOLSCOND_SCHEDULE_SIZE 4096
+
+// Magic constant: default byte capacity of a lightweight back-end's compact output buffer.
+// Back-ends don't allow overlap, so this holds a few thousand pulse edges at typical spacings. Output is normally read
+// every block, so this only needs to cover one block's worth of pulses.
+#define TTLTOOLSCOND_BACKEND_BUF_BYTES 8192
+
 // Class declarations.
 namespace TTLTools
 {
+	class EdgeFrontEnd;
+
 	// Configuration for processing conditions on one signal.
 	// Nothing in here is dynamically allocated, so copy-by-value is fine.
 	class COMMON_LIB ConditionConfig
@@ -26,6 +37,8 @@ namespace TTLTools
 		int64 deadTimeSamps;
 		int64 deglitchSamps;
 		bool outputActiveHigh;
+		// If this is set, dead time can be shorter than (delay + sustain). Overlapping pulses are merged.
+		bool allowOverlap;
 
 		// Constructor.
 		ConditionConfig();
@@ -46,33 +59,200 @@ namespace TTLTools
 	public:
 		// Constructor.
 		ConditionProcessor();
-		// Default destructor is fine.
+		// Destructor. This detaches us from our front-end, if we have one.
+		~ConditionProcessor() override;
 
 		// Accessors.
 
 		void setConfig(ConditionConfig &newConfig);
 		ConditionConfig getConfig();
 
+		// Live configuration changes. Unlike setConfig(), these keep queued output and carry trigger state forward
+		// under the new parameters (the last edge and last trigger times are kept; stable and ready times are recomputed).
+		// Changing output polarity releases all scheduled output under the old polarity, then switches the idle level just
+		// after the last released edge. New pulses can't start until after that switch.
+		// requestConfig() is lock-free and may be called from one other thread (e.g. the UI thread). The newest request
+		// is picked up by the processing thread at the start of the next advanceToTime() call (the block boundary).
+		// NOTE - Back-ends of an EdgeFrontEnd always use the front-end's deglitch interval. A configuration with a different
+		// one gets the front-end's instead (with a warning), when it's set or applied.
+		void requestConfig(const ConditionConfig &newConfig);
+		bool applyPendingConfig();
+		void applyConfigLive(const ConditionConfig &newConfig);
+
 		void clearBuffer() override;
 		void resetTrigger();
 		void handleInput(int64 inputTime, bool inputLevel, int inputTag = 0) override;
+		void handleInputBatch(const LogicEvent *inputEvents, int eventCount) override;
 		void advanceToTime(int64 newTime) override;
+		// Budgeted advance. This stops early, between phantom events, once it has checked "maxEvents" phantom events or
+		// passed the deadline (see WorkBudget). This returns the time reached; output is final up to that time.
+		// Call this again (or call advanceToTime()) to continue.
+		int64 advanceToTimeBudgeted(int64 newTime, int maxEvents, int64 deadlineTicks = 0);
+
+		// Input from a shared front-end (EdgeFrontEnd), which has already done edge detection and stable time tracking.
+		void handleFrontEndInput(int64 inputTime, bool inputLevel, bool haveRising, bool haveFalling, int64 stableTime);
+
+		// Checkpointing. This includes the configuration, trigger state, and random number generator state.
+		void writeState(MemoryOutputStream &dest) override;
+		bool readState(MemoryInputStream &source) override;
+
+		// This returns true if the other processor would produce the same output as this one from here on, given the
+		// same input. Queued output and acknowledgement history aren't compared.
+		bool matchesTriggerState(ConditionProcessor &other);
 
 	protected:
 		Random rng;
 
 		ConditionConfig config;
+		TripleBuffer<ConditionConfig> pendingConfig;
 
 		int64 nextStableTime;
 		int64 nextReadyTime;
 		bool edgeTriggerPrimed;
 		bool timesValid;
 
+		// Shared front-end feeding us, if any. Only the front-end sets this.
+		friend class EdgeFrontEnd;
+		EdgeFrontEnd* frontEnd;
+		// This forces the configuration's deglitch interval to match the front-end's, if we have one.
+		void matchFrontEndDeglitch(ConditionConfig &thisConfig);
+
 		// This returns true if "nextStableTime" or "nextReadyTime" changed.
 		bool checkForTrigger(int64 thisTime, bool thisLevel);
+		// This is checkForTrigger() after edge detection. This returns true if "nextReadyTime" changed.
+		bool checkForTriggerWithEdges(int64 thisTime, bool thisLevel, bool haveRising, bool haveFalling);
+
+		// Trigger checking is specialized at compile time for each feature type, and for zero and nonzero deglitch
+		// time and delay jitter. The two functions above call whichever variants were selected for the current configuration.
+		typedef bool (ConditionProcessor::*TriggerCheckFunc)(int64 thisTime, bool thisLevel);
+		typedef bool (ConditionProcessor::*EdgeTriggerCheckFunc)(int64 thisTime, bool thisLevel, bool haveRising, bool haveFalling);
+		TriggerCheckFunc triggerChecker;
+		EdgeTriggerCheckFunc edgeTriggerChecker;
+
+		void selectTriggerCheckers();
+		template <int featureType, bool haveDeglitch, bool haveJitter>
+			bool checkForTriggerSpecialized(int64 thisTime, bool thisLevel);
+		template <int featureType, bool haveDeglitch, bool haveJitter>
+			bool checkForTriggerWithEdgesSpecialized(int64 thisTime, bool thisLevel, bool haveRising, bool haveFalling);
+		// This checks for phantom events (becoming stable, becoming ready) up to the specified time.
+		// With a work budget, this returns false if it stopped early. Phantom events are handled up to "prevInputTime".
+		bool checkPhantomEventsUntil(int64 newTime, int maxEvents = 0, int64 deadlineTicks = 0);
+
+		// Output scheduling. Without overlap, pulses are enqueued directly, since they're already in order.
+		// With overlap, pulse edges go into a time-ordered heap and are released to the output once they're final.
+		// Each pulse adds +1 at its start and -1 at its end; output is asserted while the sum is positive.
+		int64 scheduledTimes[TTLTOOLSCOND_SCHEDULE_SIZE];
+		int scheduledDeltas[TTLTOOLSCOND_SCHEDULE_SIZE];
+		int scheduledCount;
+		int activePulseCount;
+
+		void clearSchedule();
+		void schedulePulse(int64 startTime, int64 endTime);
+		void pushScheduledEdge(int64 edgeTime, int edgeDelta);
+		void popScheduledEdge();
+		// This moves scheduled edges up to and including the specified time to the output, merging overlapping pulses.
+		void releaseScheduledOutput(int64 untilTime);
+	};
+
+
+	// Lightweight trigger back-end for an EdgeFrontEnd.
+	// This holds only dead time, delay, and sustain state, and queues output pulses in a small compact buffer. Edge
+	// detection and stable time tracking come from the front-end. Output is the same as a ConditionProcessor's with
+	// the same configuration.
+	// NOTE - Overlapping pulses aren't supported; "allowOverlap" is forced off. Use a ConditionProcessor back-end for that.
+	// NOTE - There's no live configuration change other than the front-end's deglitch interval; setConfig() resets state.
+	// NOTE - Input given directly (rather than via a front-end) gets its own edge detection, so this works stand-alone too.
+	class COMMON_LIB ConditionBackEnd : public LogicFIFO
+	{
+	public:
+		// Constructor. This selects compact output storage with TTLTOOLSCOND_BACKEND_BUF_BYTES of capacity.
+		ConditionBackEnd();
+		// Destructor. This detaches us from our front-end, if we have one.
+		~ConditionBackEnd() override;
+
+		// Accessors.
+
+		void setConfig(ConditionConfig &newConfig);
+		ConditionConfig getConfig();
+
+		void clearBuffer() override;
+		void resetTrigger();
+		void handleInput(int64 inputTime, bool inputLevel, int inputTag = 0) override;
+		void advanceToTime(int64 newTime) override;
+
+		// Input from a shared front-end (EdgeFrontEnd), which has already done edge detection and stable time tracking.
+		void handleFrontEndInput(int64 inputTime, bool inputLevel, bool haveRising, bool haveFalling, int64 stableTime);
+
+		// Checkpointing. This includes the configuration, trigger state, and random number generator state.
+		void writeState(MemoryOutputStream &dest) override;
+		bool readState(MemoryInputStream &source) override;
+
+	protected:
+		Random rng;
+		ConditionConfig config;
+
+		int64 nextStableTime;
+		int64 nextReadyTime;
+		bool edgeTriggerPrimed;
+		bool timesValid;
+
+		// Shared front-end feeding us, if any. Only the front-end sets this.
+		friend class EdgeFrontEnd;
+		EdgeFrontEnd* frontEnd;
+		// Live deglitch change from the front-end. This carries trigger state forward, like ConditionProcessor::applyConfigLive().
+		void applyDeglitchLive(int64 newDeglitch);
+
+		// This checks to see if trigger conditions are met and enqueues an output pulse if so.
+		// This is ConditionProcessor's trigger check without the compile-time specialization.
+		void checkForTrigger(int64 thisTime, bool thisLevel, bool haveRising, bool haveFalling);
 		// This checks for phantom events (becoming stable, becoming ready) up to the specified time.
 		void checkPhantomEventsUntil(int64 newTime);
 	};
+
+
+	// Shared edge-detection front-end for several condition processors watching the same TTL signal.
+	// This does edge detection and stable time tracking once per input event, and hands the results to any number of
+	// back-ends, which then only do their own dead time, trigger, and output logic.
+	// Back-ends must all use the front-end's deglitch interval; other parameters (delays, sustain, dead time, feature) can differ.
+	// NOTE - Feed input to the front-end, not to the back-ends. Back-end output is read from the back-ends as usual.
+	// NOTE - Back-ends can be lightweight (ConditionBackEnd) or full ConditionProcessors. A full processor costs as much
+	// as a stand-alone one; use those only for overlapping pulses or live configuration changes.
+	class COMMON_LIB EdgeFrontEnd : public LogicFIFO
+	{
+	public:
+		// Constructor.
+		EdgeFrontEnd();
+		// Destructor. This detaches the back-ends.
+		~EdgeFrontEnd() override;
+
+		// Configuration. Changing the deglitch interval changes it in every back-end too, as a live configuration change.
+		void setDeglitchSamps(int64 newDeglitch);
+		int64 getDeglitchSamps();
+
+		void clearBackEnds();
+		// A back-end can only have one front-end; adding it here removes it from any other front-end.
+		void addBackEnd(ConditionProcessor* newBackEnd);
+		void removeBackEnd(ConditionProcessor* oldBackEnd);
+		void addBackEnd(ConditionBackEnd* newBackEnd);
+		void removeBackEnd(ConditionBackEnd* oldBackEnd);
+
+		// Accessors.
+		void clearBuffer() override;
+		void resetEdgeState();
+		void handleInput(int64 inputTime, bool inputLevel, int inputTag = 0) override;
+		void handleInputBatch(const LogicEvent *inputEvents, int eventCount) override;
+		void advanceToTime(int64 newTime) override;
+
+		void writeState(MemoryOutputStream &dest) override;
+		bool readState(MemoryInputStream &source) override;
+
+	protected:
+		int64 deglitchSamps;
+		Array<ConditionProcessor*> backEndList;
+		Array<ConditionBackEnd*> lightBackEndList;
+
+		int64 nextStableTime;
+	};
 }
 
 #endif
@@ -13,6 +13,9 @@
 // Condition bypass switch. Set this to make conditional triggers act like FIFOs.
 #define LOGICDEBUG_BYPASSCONDITION 0
 
+// Profiling enable switch (does not require debug enabled). See "TTLToolsProfile.h".
+#define LOGICWANTPROFILE 0
+
 
 // Diagnostic tattle macros.
 
@@ -50,4 +53,17 @@
 #endif
 
 
+// Profiling hooks.
+// L_PROFILE_SCOPE records one call to the enclosing scope and the cycles spent in it.
+// L_PROFILE_EVENTS records events processed (events per call varies, so cycles per event is the useful figure).
+// These compile to nothing if profiling is disabled.
+#if LOGICWANTPROFILE
+#define L_PROFILE_SCOPE(slot) TTLTools::ProfileScope profileScopeInstance(TTLTools::LogicProfiler::slot);
+#define L_PROFILE_EVENTS(slot, count) TTLTools::LogicProfiler::recordEvents(TTLTools::LogicProfiler::slot, count);
+#else
+#define L_PROFILE_SCOPE(slot) {}
+#define L_PROFILE_EVENTS(slot, count) {}
+#endif
+
+
 #endif
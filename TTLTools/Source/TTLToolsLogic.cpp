@@ -3,6 +3,8 @@
 #define LOGICDEBUGIDVARIABLE debugID
 #include "TTLToolsDebug.h"
 
+#include <typeinfo>
+
 using namespace TTLTools;
 
 // Private constants.
@@ -10,6 +12,16 @@ using namespace TTLTools;
 // This timestamp could happen, but we need _something_ as the default.
 #define LOGIC_TIMESTAMP_BOGUS (-1)
 
+// Checkpoint section markers. These catch attempts to restore state saved by a different class.
+#define LOGIC_STATE_MAGIC_FIFO 0x4f464946
+#define LOGIC_STATE_MAGIC_LOGICMERGER 0x4d474f4c
+#define LOGIC_STATE_MAGIC_TRUTHMERGER 0x4d485254
+#define LOGIC_STATE_MAGIC_REORDER 0x44524f52
+#define LOGIC_STATE_MAGIC_TAGDEMUX 0x584d4454
+
+// Ring buffer index mask for held events.
+#define LOGIC_REORDER_MASK (TTLTOOLSLOGIC_REORDER_SIZE - 1)
+
 
 //
 // Base class for output buffer handling.
@@ -19,23 +31,46 @@ using namespace TTLTools;
 LogicFIFO::LogicFIFO()
 {
     debugID = LOGICDEBUG_DEFAULT_DEBUGID;
+    useCompactOutput = false;
+    fixedOutput = new FixedEventBuf;
+    overloadPolicy = overloadDropNewest;
+    pullSource = NULL;
     clearBuffer();
     setPrevInput(LOGIC_TIMESTAMP_BOGUS, false);
 }
 
 
+// Destructor.
+LogicFIFO::~LogicFIFO()
+{
+    // Mergers detach from us when they're destroyed; we don't own them. We do own our output buffer.
+    if (NULL != fixedOutput)
+        delete fixedOutput;
+}
+
+
 // State manipulation.
 
 // Buffer reset. This clears queued output and sets past output to false.
 void LogicFIFO::clearBuffer()
 {
-    pendingOutputTimes.clear();
-    pendingOutputLevels.clear();
-    pendingOutputTags.clear();
+    if (NULL != fixedOutput)
+    {
+        fixedOutput->times.clear();
+        fixedOutput->levels.clear();
+        fixedOutput->tags.clear();
+    }
+    compactOutput.clear();
 
     prevAcknowledgedTime = LOGIC_TIMESTAMP_BOGUS;
     prevAcknowledgedLevel = false;
     prevAcknowledgedTag = 0;
+
+    // Nothing is known about future input after a reset.
+    watermarkTime = LOGIC_TIMESTAMP_BOGUS;
+    pulledUntilTime = LOGIC_TIMESTAMP_BOGUS;
+
+    overloadCount = 0;
 }
 
 
@@ -49,6 +84,90 @@ void LogicFIFO::setPrevInput(int64 resetTime, bool newInput, int newTag)
 }
 
 
+// Compact storage selection. This delta-encodes queued output, trading some CPU time for holding more events.
+// This should be called during setup, since it allocates. Pending output that doesn't fit in the new storage is
+// handled by the overload policy, same as during normal operation.
+void LogicFIFO::setCompactStorage(bool wantCompact, size_t byteCapacity)
+{
+    // Move pending output to a temporary heap buffer, since we may be resizing the buffer it's in.
+    Array<LogicEvent> movedEvents;
+    movedEvents.ensureStorageAllocated((int) getPendingOutputCount());
+    while (hasPendingOutput())
+    {
+        movedEvents.add(LogicEvent(getNextOutputTime(), getNextOutputLevel(), getNextOutputTag()));
+        // Don't call acknowledgeOutput(); that would change the "last acknowledged" record.
+        if (useCompactOutput)
+            compactOutput.dequeue();
+        else
+        {
+            fixedOutput->times.dequeue();
+            fixedOutput->levels.dequeue();
+            fixedOutput->tags.dequeue();
+        }
+    }
+
+    // Only one of the buffers is kept allocated.
+    useCompactOutput = wantCompact;
+    compactOutput.setCapacity(wantCompact ? byteCapacity : 0);
+    if (wantCompact && (NULL != fixedOutput))
+    {
+        delete fixedOutput;
+        fixedOutput = NULL;
+    }
+    else if ((!wantCompact) && (NULL == fixedOutput))
+        fixedOutput = new FixedEventBuf;
+
+    for (int evIdx = 0; evIdx < movedEvents.size(); evIdx++)
+    {
+        LogicEvent &thisEvent = movedEvents.getReference(evIdx);
+        if (!storeOutput(thisEvent.time, thisEvent.level, thisEvent.tag))
+            handleOverload(thisEvent.time, thisEvent.level, thisEvent.tag);
+    }
+
+    // Moved output was stored directly, so make sure that subscribed mergers know it's there.
+    if (hasPendingOutput())
+        notifyConsumers();
+}
+
+
+bool LogicFIFO::isUsingCompactStorage()
+{
+    return useCompactOutput;
+}
+
+
+// Overload handling. The overload flag is set whenever an event is discarded or coalesced.
+
+void LogicFIFO::setOverloadPolicy(OverloadPolicy newPolicy)
+{
+    overloadPolicy = newPolicy;
+}
+
+
+LogicFIFO::OverloadPolicy LogicFIFO::getOverloadPolicy()
+{
+    return overloadPolicy;
+}
+
+
+bool LogicFIFO::hasOverloaded()
+{
+    return (overloadCount > 0);
+}
+
+
+int64 LogicFIFO::getOverloadCount()
+{
+    return overloadCount;
+}
+
+
+void LogicFIFO::clearOverloadFlag()
+{
+    overloadCount = 0;
+}
+
+
 // Input processing. For the FIFO, input events are just copied to the output.
 void LogicFIFO::handleInput(int64 inputTime, bool inputLevel, int inputTag)
 {
@@ -61,41 +180,127 @@ void LogicFIFO::handleInput(int64 inputTime, bool inputLevel, int inputTag)
     // Update the "last input seen" record.
     // Doing this after enqueue so that enqueue can check the previous state.
     setPrevInput(inputTime, inputLevel, inputTag);
+
+    // More input may arrive with this timestamp, but not before it.
+    advanceWatermark(inputTime - 1);
 }
 
 
 // Input processing. This advances the internal time to the specified timestamp.
+// This also declares that input is complete up to and including this timestamp.
 void LogicFIFO::advanceToTime(int64 newTime)
 {
-    // Nothing to do for the base class.
+    // Nothing else to do for the base class.
+    advanceWatermark(newTime);
+}
+
+
+// Batch input. This calls handleInput() for each event, so that child classes that only override handleInput() still
+// see every event. For the FIFO itself, input events are just copied to the output.
+void LogicFIFO::handleInputBatch(const LogicEvent *inputEvents, int eventCount)
+{
+    // This is one check per batch, rather than one virtual call per event.
+    if (typeid(*this) == typeid(LogicFIFO))
+        copyInputBatch(inputEvents, eventCount);
+    else
+        for (int evIdx = 0; evIdx < eventCount; evIdx++)
+            handleInput(inputEvents[evIdx].time, inputEvents[evIdx].level, inputEvents[evIdx].tag);
+}
+
+
+// This copies input events to the output, with the watermark only updated at the end.
+void LogicFIFO::copyInputBatch(const LogicEvent *inputEvents, int eventCount)
+{
+    for (int evIdx = 0; evIdx < eventCount; evIdx++)
+    {
+        const LogicEvent &thisEvent = inputEvents[evIdx];
+
+        enqueueOutput(thisEvent.time, thisEvent.level, thisEvent.tag);
+        setPrevInput(thisEvent.time, thisEvent.level, thisEvent.tag);
+    }
+
+    // More input may arrive with the last timestamp, but not before it.
+    if (eventCount > 0)
+        advanceWatermark(inputEvents[eventCount - 1].time - 1);
 }
 
 
-// Input processing. This pulls from another FIFO the same way merger classes do, calling handleInput() to process pulled events.
+// Input processing. This pulls from another FIFO the same way merger classes do, calling handleInputBatch() to process pulled events.
 // Events with the same timestamp are merged (only the last event is forwarded).
+// The source must be complete up to newTime; this calls advanceToTime(newTime) when done.
 void LogicFIFO::pullFromFIFOUntil(LogicFIFO *source, int64 newTime)
 {
-    bool hadInput = true;
+    L_PROFILE_SCOPE(profilePullFromFIFO)
+
+    LogicEvent batchEvents[TTLTOOLSLOGIC_BATCH_SIZE];
+    int batchCount = 0;
 
     if (NULL != source)
-        while (hadInput)
+        while ( (source->hasPendingOutput()) && (source->getNextOutputTime() <= newTime) )
         {
-            hadInput = false;
-            if (source->hasPendingOutput())
-            {
-                int64 thisTime = source->getNextOutputTime();
-                if (thisTime <= newTime)
-                {
-                    hadInput = true;
+            int64 thisTime = source->getNextOutputTime();
 
-                    // Acknowledge everything with this timestamp, so that we're only dealing with the last relevant event.
-                    while ( (source->hasPendingOutput()) && ( (source->getNextOutputTime()) == thisTime ) )
-                        source->acknowledgeOutput();
+            // Acknowledge everything with this timestamp, so that we're only dealing with the last relevant event.
+            while ( (source->hasPendingOutput()) && ( (source->getNextOutputTime()) == thisTime ) )
+                source->acknowledgeOutput();
 
-                    handleInput(thisTime, source->getLastAcknowledgedLevel(), source->getLastAcknowledgedTag());
-                }
+            batchEvents[batchCount] = LogicEvent(thisTime, source->getLastAcknowledgedLevel(), source->getLastAcknowledgedTag());
+            batchCount++;
+
+            if (batchCount >= TTLTOOLSLOGIC_BATCH_SIZE)
+            {
+                handleInputBatch(batchEvents, batchCount);
+                L_PROFILE_EVENTS(profilePullFromFIFO, batchCount)
+                batchCount = 0;
             }
         }
+
+    if (batchCount > 0)
+    {
+        handleInputBatch(batchEvents, batchCount);
+        L_PROFILE_EVENTS(profilePullFromFIFO, batchCount)
+    }
+
+    // The caller guarantees that the source is complete up to newTime, so our input is too.
+    advanceToTime(newTime);
+}
+
+
+// Lazy pulling.
+
+void LogicFIFO::setPullSource(LogicFIFO *newSource)
+{
+    pullSource = newSource;
+}
+
+
+LogicFIFO* LogicFIFO::getPullSource()
+{
+    return pullSource;
+}
+
+
+// This pulls one timestamp's worth of input from the pull source, or has the source do more work first.
+// This returns false if no more output can be produced up to untilTime without more external input.
+bool LogicFIFO::pullMoreOutput(int64 untilTime)
+{
+    if ( (NULL == pullSource) || (pulledUntilTime >= untilTime) )
+        return false;
+
+    // Step to the source's next event, or all the way if there isn't one before then.
+    int64 stepTime = untilTime;
+    if ( pullSource->hasPendingOutput() && (pullSource->getNextOutputTime() < stepTime) )
+        stepTime = pullSource->getNextOutputTime();
+
+    // The source has to be final up to the step time. If it isn't, and can't do more work on its own, then it's fed
+    // externally, and the caller guarantees that it's complete.
+    if ( (pullSource->getWatermark() < stepTime) && pullSource->pullMoreOutput(stepTime) )
+        return true;
+
+    pullFromFIFOUntil(pullSource, stepTime);
+    pulledUntilTime = stepTime;
+
+    return true;
 }
 
 
@@ -103,28 +308,34 @@ void LogicFIFO::pullFromFIFOUntil(LogicFIFO *source, int64 newTime)
 
 bool LogicFIFO::hasPendingOutput()
 {
-    return (pendingOutputTimes.count() > 0);
+    return (getPendingOutputCount() > 0);
+}
+
+
+size_t LogicFIFO::getPendingOutputCount()
+{
+    return ( useCompactOutput ? compactOutput.count() : fixedOutput->times.count() );
 }
 
 
 int64 LogicFIFO::getNextOutputTime()
 {
     // NOTE - This will return a safe value (0) if we don't have output.
-    return pendingOutputTimes.snoop();
+    return ( useCompactOutput ? compactOutput.snoopTime() : fixedOutput->times.snoop() );
 }
 
 
 bool LogicFIFO::getNextOutputLevel()
 {
     // NOTE - This will return a safe value (false) if we don't have output.
-    return pendingOutputLevels.snoop();
+    return ( useCompactOutput ? compactOutput.snoopLevel() : fixedOutput->levels.snoop() );
 }
 
 
 int LogicFIFO::getNextOutputTag()
 {
     // NOTE - This will return a safe value (0) if we don't have output.
-    return pendingOutputTags.snoop();
+    return ( useCompactOutput ? compactOutput.snoopTag() : fixedOutput->tags.snoop() );
 }
 
 
@@ -134,15 +345,19 @@ void LogicFIFO::acknowledgeOutput()
     if (hasPendingOutput())
     {
         // Save whatever the last output was.
-        // These will return safe values (0 or false) if we don't have pending output.
-        prevAcknowledgedTime = pendingOutputTimes.snoop();
-        prevAcknowledgedLevel = pendingOutputLevels.snoop();
-        prevAcknowledgedTag = pendingOutputTags.snoop();
+        prevAcknowledgedTime = getNextOutputTime();
+        prevAcknowledgedLevel = getNextOutputLevel();
+        prevAcknowledgedTag = getNextOutputTag();
 
         // Discard return values.
-        pendingOutputTimes.dequeue();
-        pendingOutputLevels.dequeue();
-        pendingOutputTags.dequeue();
+        if (useCompactOutput)
+            compactOutput.dequeue();
+        else
+        {
+            fixedOutput->times.dequeue();
+            fixedOutput->levels.dequeue();
+            fixedOutput->tags.dequeue();
+        }
     }
 }
 
@@ -150,8 +365,68 @@ void LogicFIFO::acknowledgeOutput()
 // This acknowledges and discards output up to and including the specified timestamp.
 void LogicFIFO::drainOutputUntil(int64 newTime)
 {
-    while ( hasPendingOutput() && (pendingOutputTimes.snoop() <= newTime) )
+    while ( hasPendingOutput() && (getNextOutputTime() <= newTime) )
+        acknowledgeOutput();
+}
+
+
+// Batch output. This copies and acknowledges up to maxEvents queued events, returning the number copied.
+int LogicFIFO::readOutputBatch(LogicEvent *destEvents, int maxEvents)
+{
+    int eventCount = 0;
+
+    while ( (eventCount < maxEvents) && hasPendingOutput() )
+    {
+        destEvents[eventCount] = LogicEvent(getNextOutputTime(), getNextOutputLevel(), getNextOutputTag());
+        acknowledgeOutput();
+        eventCount++;
+    }
+
+    return eventCount;
+}
+
+
+// Single-event output. This copies and acknowledges the next queued event.
+bool LogicFIFO::readNextOutput(LogicEvent &destEvent)
+{
+    if (!hasPendingOutput())
+        return false;
+
+    destEvent = LogicEvent(getNextOutputTime(), getNextOutputLevel(), getNextOutputTag());
+    acknowledgeOutput();
+
+    return true;
+}
+
+
+// Single-event output. This only returns events up to and including untilTime, and only pulls as much input as it needs.
+bool LogicFIFO::readNextOutputUntil(LogicEvent &destEvent, int64 untilTime)
+{
+    while (!hasPendingOutput())
+        if (!pullMoreOutput(untilTime))
+            return false;
+
+    // Output is in time order, so if the next event is too late, there won't be anything earlier.
+    if (getNextOutputTime() > untilTime)
+        return false;
+
+    return readNextOutput(destEvent);
+}
+
+
+// Batch output. This only reads events up to and including untilTime.
+int LogicFIFO::readOutputBatchUntil(LogicEvent *destEvents, int maxEvents, int64 untilTime)
+{
+    int eventCount = 0;
+
+    while ( (eventCount < maxEvents) && hasPendingOutput() && (getNextOutputTime() <= untilTime) )
+    {
+        destEvents[eventCount] = LogicEvent(getNextOutputTime(), getNextOutputLevel(), getNextOutputTag());
         acknowledgeOutput();
+        eventCount++;
+    }
+
+    return eventCount;
 }
 
 
@@ -191,6 +466,13 @@ int LogicFIFO::getLastAcknowledgedTag()
 }
 
 
+// Output watermark. No further output will be enqueued with a timestamp at or before this time.
+int64 LogicFIFO::getWatermark()
+{
+    return watermarkTime;
+}
+
+
 // Copy-by-value accessor. This is used for splitting output.
 // The idea is that we don't need to know the type of a derived class to get a basic FIFO with a copy of that object's output.
 
@@ -200,9 +482,17 @@ LogicFIFO* LogicFIFO::getCopyByValue()
 
     // All of our internal data fields, including buffers, can be copied by value.
 
-    result->pendingOutputTimes = pendingOutputTimes;
-    result->pendingOutputLevels = pendingOutputLevels;
-    result->pendingOutputTags = pendingOutputTags;
+    // The new FIFO starts out with a fixed-size buffer, so swap that out if we're using compact storage.
+    if (NULL == fixedOutput)
+    {
+        delete result->fixedOutput;
+        result->fixedOutput = NULL;
+    }
+    else
+        *(result->fixedOutput) = *fixedOutput;
+
+    result->compactOutput = compactOutput;
+    result->useCompactOutput = useCompactOutput;
 
     result->prevInputTime = prevInputTime;
     result->prevInputLevel = prevInputLevel;
@@ -212,6 +502,11 @@ LogicFIFO* LogicFIFO::getCopyByValue()
     result->prevAcknowledgedLevel = prevAcknowledgedLevel;
     result->prevAcknowledgedTag = prevAcknowledgedTag;
 
+    result->watermarkTime = watermarkTime;
+
+    result->overloadPolicy = overloadPolicy;
+    result->overloadCount = overloadCount;
+
     return result;
 }
 
@@ -223,255 +518,1807 @@ void LogicFIFO::setDebugID(int newID)
 }
 
 
-// Protected accessors.
-
-void LogicFIFO::enqueueOutput(int64 newTime, bool newLevel, int newTag)
+// Checkpointing. This saves all processing state, including queued output.
+void LogicFIFO::writeState(MemoryOutputStream &dest)
 {
-    pendingOutputTimes.enqueue(newTime);
-    pendingOutputLevels.enqueue(newLevel);
-    pendingOutputTags.enqueue(newTag);
-// FIXME - Spammy diagnostics.
-//L_PRINT(".. fifo output enqueued for tag " << newTag << " level " << (newLevel ? 1 : 0) << " at time " << newTime << ".");
+    dest.writeInt(LOGIC_STATE_MAGIC_FIFO);
 
-    // Sanity check for debugging.
-    // NOTE - This may give false alarms if input wasn't initialized (reset) before enqueueOutput was called!
-    if (prevInputTime > newTime)
+    int eventCount = (int) getPendingOutputCount();
+    dest.writeInt(eventCount);
+    if (useCompactOutput)
     {
-        // FIXME - This can get spammy if there's a bug that trips it!
-        L_WARN(".. WARNING - FIFO event enqueued out of order (prev time " << prevInputTime << ", new " << newTime << ").");
+        // Compact storage can only be read destructively, so walk a copy of it.
+        CompactEventBuf scratch = compactOutput;
+        for (int eIdx = 0; eIdx < eventCount; eIdx++)
+        {
+            dest.writeInt64(scratch.snoopTime());
+            dest.writeBool(scratch.snoopLevel());
+            dest.writeInt(scratch.snoopTag());
+            scratch.dequeue();
+        }
     }
-}
+    else
+        for (int eIdx = 0; eIdx < eventCount; eIdx++)
+        {
+            dest.writeInt64(fixedOutput->times.snoopAt(eIdx));
+            dest.writeBool(fixedOutput->levels.snoopAt(eIdx));
+            dest.writeInt(fixedOutput->tags.snoopAt(eIdx));
+        }
 
+    dest.writeInt64(prevInputTime);
+    dest.writeBool(prevInputLevel);
+    dest.writeInt(prevInputTag);
 
+    dest.writeInt64(prevAcknowledgedTime);
+    dest.writeBool(prevAcknowledgedLevel);
+    dest.writeInt(prevAcknowledgedTag);
 
-//
-// Merging of multiple FIFO outputs - Base class.
+    dest.writeInt64(watermarkTime);
 
-// This works by pulling, to avoid needing input buffers.
-// The base class implements features shared by the multiplexer and the logical merger.
+    dest.writeInt((int) overloadPolicy);
+    dest.writeInt64(overloadCount);
+}
 
 
-// Constructor.
-MergerBase::MergerBase()
+// Checkpointing. This restores state saved by writeState(). Nothing is changed if the saved data is bad.
+bool LogicFIFO::readState(MemoryInputStream &source)
 {
-    clearInputList();
-    clearMergeState();
+    if (source.getNumBytesRemaining() < 8)
+        return false;
+    if (LOGIC_STATE_MAGIC_FIFO != source.readInt())
+        return false;
 
-    // Our output buffer was cleared by the LogicFIFO constructor, and we have no inputs yet, so nothing more to do.
-}
+    int eventCount = source.readInt();
+    if (!checkSavedEventCount(eventCount, source))
+        return false;
 
+    // Everything's present, so we can't fail past this point. Overwrite our state.
 
-// Accessors.
+    if (NULL != fixedOutput)
+    {
+        fixedOutput->times.clear();
+        fixedOutput->levels.clear();
+        fixedOutput->tags.clear();
+    }
+    compactOutput.clear();
 
-void MergerBase::clearInputList()
-{
-    inputList.clear();
-    inputTags.clear();
-}
+    int64 droppedCount = 0;
+    for (int eIdx = 0; eIdx < eventCount; eIdx++)
+    {
+        int64 thisTime = source.readInt64();
+        bool thisLevel = source.readBool();
+        int thisTag = source.readInt();
+        if (!storeOutput(thisTime, thisLevel, thisTag))
+            droppedCount++;
+    }
 
+    // Restored output has to be visited by subscribed mergers, same as newly enqueued output.
+    if (eventCount > 0)
+        notifyConsumers();
 
-void MergerBase::addInput(LogicFIFO* newInput, int idTag)
-{
-    inputList.add(newInput);
-    inputTags.add(idTag);
-}
+    prevInputTime = source.readInt64();
+    prevInputLevel = source.readBool();
+    prevInputTag = source.readInt();
 
+    prevAcknowledgedTime = source.readInt64();
+    prevAcknowledgedLevel = source.readBool();
+    prevAcknowledgedTag = source.readInt();
 
-void MergerBase::clearBuffer()
-{
-    LogicFIFO::clearBuffer();
+    watermarkTime = source.readInt64();
 
-    for (int inIdx = 0; inIdx < inputList.size(); inIdx++)
-        if (NULL != inputList[inIdx])
-            (inputList[inIdx])->clearBuffer();
-}
+    overloadPolicy = (OverloadPolicy) source.readInt();
+    overloadCount = source.readInt64() + droppedCount;
 
+    if (droppedCount > 0)
+    {
+        L_WARN(".. WARNING - Restored FIFO output didn't fit; discarded " << droppedCount << " events.");
+    }
 
-void MergerBase::clearMergeState()
-{
-    // Nothing to do.
+    return true;
 }
 
 
-// This acknowledges all input up to the specified timestamp.
-void MergerBase::advanceToTime(int64 newTime)
+// This checks saved state without restoring it, and skips past it.
+bool LogicFIFO::skipState(MemoryInputStream &source)
 {
-    // Acknowledge all events that are at or before this timestamp.
-    // Even if we picked the earliest timestamp, a source may still have several pending events at that time (zero-delay glitching).
-    for (int inIdx = 0; inIdx < inputList.size(); inIdx++)
-        if (NULL != inputList[inIdx])
-        {
-            bool wasEarly = true;
-            while ( wasEarly && (inputList[inIdx]->hasPendingOutput()) )
-                if (inputList[inIdx]->getNextOutputTime() <= newTime)
-                    inputList[inIdx]->acknowledgeOutput();
-                else
-                    wasEarly = false;
-        }
+    if (source.getNumBytesRemaining() < 8)
+        return false;
+    if (LOGIC_STATE_MAGIC_FIFO != source.readInt())
+        return false;
+
+    int eventCount = source.readInt();
+    if (!checkSavedEventCount(eventCount, source))
+        return false;
+
+    source.setPosition(source.getPosition() + 13 * (int64) eventCount + 46);
+    return true;
 }
 
 
-bool MergerBase::havePendingInput()
+// Each event takes 13 bytes, and the trailing state takes 46 bytes.
+// NOTE - If compact storage is selected and too small, excess events are discarded and counted as overloads, so only
+// the fixed-size buffer limits the event count.
+bool LogicFIFO::checkSavedEventCount(int eventCount, MemoryInputStream &source)
 {
-    bool hadInput = false;
-
-    for (int inIdx = 0; inIdx < inputList.size(); inIdx++)
-        if (NULL != inputList[inIdx])
-            if (inputList[inIdx]->hasPendingOutput())
-                hadInput = true;
+    if ( (eventCount < 0)
+        || ( (!useCompactOutput) && (eventCount > TTLTOOLSLOGIC_EVENT_BUF_SIZE) )
+        || (source.getNumBytesRemaining() < (13 * (int64) eventCount + 46)) )
+        return false;
 
-    // Done.
-    return hadInput;
+    return true;
 }
 
 
-// This finds the earliest timestamp in the still-pending input. It returns a bogus default value if there is no input, so check that first.
-int64 MergerBase::findNextInputTime()
+// Convenience wrappers for checkpointing to/from a flat buffer.
+
+void LogicFIFO::saveState(MemoryBlock &dest)
 {
-    int64 earliestTime = LOGIC_TIMESTAMP_BOGUS;
-    bool hadInput = false;
+    MemoryOutputStream stream(dest, false);
+    writeState(stream);
+}
 
-    // Identify the oldest pending timestamp and record it.
-    for (int inIdx = 0; inIdx < inputList.size(); inIdx++)
-        if (NULL != inputList[inIdx])
-            if (inputList[inIdx]->hasPendingOutput())
-            {
-                int64 thisTime = inputList[inIdx]->getNextOutputTime();
-                if ((!hadInput) || (thisTime < earliestTime))
-                    earliestTime = thisTime;
-                hadInput = true;
-            }
-// FIXME - Spammy diagnostics.
-//L_PRINT("findNextInputTime found " << (hadInput ? "input" : "no input") << ", at reported time " << earliestTime << ".");
 
-    // Done.
-    return earliestTime;
+bool LogicFIFO::loadState(const MemoryBlock &source)
+{
+    MemoryInputStream stream(source, false);
+    return readState(stream);
 }
 
 
+// Protected accessors.
 
-//
-// Merging of multiple FIFO outputs - Multiplexer.
+// Subscription management. Only mergers call these.
 
-// This works by pulling, to avoid needing input buffers.
-// This is a multiplexer, combining several input streams into an in-order output stream with input identification tags.
-// Output events are tagged with the input stream's ID tag (input event tags are discarded).
+void LogicFIFO::addConsumer(MergerBase* newConsumer, int inputSlot)
+{
+    consumerList.add(newConsumer);
+    consumerSlots.add(inputSlot);
+}
 
 
-// Constructor.
-MuxMerger::MuxMerger()
+void LogicFIFO::removeConsumer(MergerBase* oldConsumer)
 {
-    // Nothing more to do. The base class constructor handled everything.
+    for (int cIdx = consumerList.size() - 1; cIdx >= 0; cIdx--)
+        if (consumerList[cIdx] == oldConsumer)
+        {
+            consumerList.remove(cIdx);
+            consumerSlots.remove(cIdx);
+        }
 }
 
 
-// Accessors.
-
-void MuxMerger::processPendingInputUntil(int64 newTime)
+// This moves the watermark forwards (never backwards).
+void LogicFIFO::advanceWatermark(int64 newTime)
 {
-    // Scan over all inputs, pick the oldest, and process it.
-    // Only do this up to the specified time.
+    if (newTime > watermarkTime)
+        watermarkTime = newTime;
+}
 
-    bool hadInput = havePendingInput();
-    int64 currentTime = findNextInputTime();
 
-// FIXME - Spammy diagnostics.
-//L_PRINT("MuxMerger advancing to " << newTime << " with " << (hadInput ? "pending input" : "no input") << " at time " << currentTime << ".");
+// This pulls every event up to newTime from the source, without merging events that have the same timestamp.
+void LogicFIFO::pullAllFromFIFOUntil(LogicFIFO *source, int64 newTime)
+{
+    L_PROFILE_SCOPE(profilePullFromFIFO)
 
-    while ( hadInput && (currentTime <= newTime) )
+    LogicEvent batchEvents[TTLTOOLSLOGIC_BATCH_SIZE];
+    int batchCount = 1;
+
+    if (NULL != source)
+        while (batchCount > 0)
+        {
+            batchCount = source->readOutputBatchUntil(batchEvents, TTLTOOLSLOGIC_BATCH_SIZE, newTime);
+            if (batchCount > 0)
+            {
+                handleInputBatch(batchEvents, batchCount);
+                L_PROFILE_EVENTS(profilePullFromFIFO, batchCount)
+            }
+        }
+
+    // The caller guarantees that the source is complete up to newTime, so our input is too.
+    advanceToTime(newTime);
+}
+
+
+void LogicFIFO::enqueueOutput(int64 newTime, bool newLevel, int newTag)
+{
+    enqueueOutputUnchecked(newTime, newLevel, newTag);
+// FIXME - Spammy diagnostics.
+//L_PRINT(".. fifo output enqueued for tag " << newTag << " level " << (newLevel ? 1 : 0) << " at time " << newTime << ".");
+
+    // Sanity check for debugging.
+    // NOTE - This may give false alarms if input wasn't initialized (reset) before enqueueOutput was called!
+    if (prevInputTime > newTime)
     {
-        // Acknowledge pending inputs.
-        advanceToTime(currentTime);
+        // FIXME - This can get spammy if there's a bug that trips it!
+        L_WARN(".. WARNING - FIFO event enqueued out of order (prev time " << prevInputTime << ", new " << newTime << ").");
+    }
+}
 
-        // Emit output events corresponding to the input events that just happened.
-        for (int inIdx = 0; inIdx < inputList.size(); inIdx++)
-            if (NULL != inputList[inIdx])
+
+// This enqueues output without checking it against the most recent input.
+// This is for output that was held back and released once it was final, which may be older than the most recent input.
+void LogicFIFO::enqueueOutputUnchecked(int64 newTime, bool newLevel, int newTag)
+{
+    L_PROFILE_SCOPE(profileEnqueueOutput)
+    L_PROFILE_EVENTS(profileEnqueueOutput, 1)
+
+    if (!storeOutput(newTime, newLevel, newTag))
+        handleOverload(newTime, newLevel, newTag);
+
+    notifyConsumers();
+}
+
+
+// This tells subscribed mergers that we have output. This is normally zero or one consumer.
+// Anything that stores output without going through enqueueOutputUnchecked() has to call this.
+void LogicFIFO::notifyConsumers()
+{
+    for (int cIdx = 0; cIdx < consumerList.size(); cIdx++)
+        consumerList[cIdx]->markInputDirty(consumerSlots[cIdx]);
+}
+
+
+// This stores an event in whichever output buffer is active, without any other bookkeeping.
+// This returns false (discarding the event) if the buffer is full.
+bool LogicFIFO::storeOutput(int64 newTime, bool newLevel, int newTag)
+{
+    if (useCompactOutput)
+        return compactOutput.enqueue(newTime, newLevel, newTag);
+
+    if (fixedOutput->times.count() >= fixedOutput->times.capacity())
+        return false;
+
+    fixedOutput->times.enqueue(newTime);
+    fixedOutput->levels.enqueue(newLevel);
+    fixedOutput->tags.enqueue(newTag);
+
+    return true;
+}
+
+
+// Overload handling. This applies the overload policy to an event that didn't fit.
+void LogicFIFO::handleOverload(int64 newTime, bool newLevel, int newTag)
+{
+    bool handled = false;
+
+    // Every policy loses or merges at least one transition.
+    overloadCount++;
+
+    if (overloadDropGlitchPairs == overloadPolicy)
+    {
+        int64 newestTime = 0;
+        bool newestLevel = false;
+        int newestTag = 0;
+        bool haveNewest = false;
+
+        if (useCompactOutput)
+            haveNewest = compactOutput.snoopNewest(newestTime, newestLevel, newestTag);
+        else if (fixedOutput->times.count() > 0)
+        {
+            newestTime = fixedOutput->times.snoopNewest();
+            newestLevel = fixedOutput->levels.snoopNewest();
+            newestTag = fixedOutput->tags.snoopNewest();
+            haveNewest = true;
+        }
+
+        // We can only pair up events from the same line. Otherwise, fall back to coalescing.
+        if (haveNewest && (newestTag == newTag))
+        {
+            handled = true;
+
+            // A level change returns the line to the level it had before the newest event, so drop both.
+            // No level change means the new event is redundant, so just drop it.
+            if (newestLevel != newLevel)
             {
-                int64 thisTime = inputList[inIdx]->getLastAcknowledgedTime();
-                if (thisTime == currentTime)
+                if (useCompactOutput)
+                    compactOutput.discardNewest();
+                else
                 {
-                    bool thisLevel = inputList[inIdx]->getLastAcknowledgedLevel();
-                    enqueueOutput(thisTime, thisLevel, inputTags[inIdx]);
+                    fixedOutput->times.discardNewest();
+                    fixedOutput->levels.discardNewest();
+                    fixedOutput->tags.discardNewest();
                 }
             }
+        }
+    }
 
-        hadInput = havePendingInput();
-        currentTime = findNextInputTime();
+    if ( (!handled) && (overloadDropNewest != overloadPolicy) )
+        if (coalesceOldestOutput())
+            storeOutput(newTime, newLevel, newTag);
+
+    // Only report the first overload since the flag was cleared, so that sustained overload isn't spammy.
+    if (1 == overloadCount)
+    {
+        L_WARN(".. WARNING - FIFO overloaded at time " << newTime << ".");
+    }
+}
+
+
+// This discards the oldest queued event if a later queued event on the same tag supersedes it.
+// The scan is bounded, so this is O(1).
+bool LogicFIFO::coalesceOldestOutput()
+{
+    bool canCoalesce = false;
+
+    if (useCompactOutput)
+    {
+        // Compact storage can only look one event past the oldest.
+        int64 secondTime = 0;
+        bool secondLevel = false;
+        int secondTag = 0;
+        if (compactOutput.snoopSecond(secondTime, secondLevel, secondTag))
+            canCoalesce = (secondTag == compactOutput.snoopTag());
+
+        if (canCoalesce)
+            compactOutput.dequeue();
+    }
+    else
+    {
+        int oldestTag = fixedOutput->tags.snoop();
+        size_t scanLimit = fixedOutput->tags.count();
+        if (scanLimit > (1 + TTLTOOLSLOGIC_COALESCE_SCAN))
+            scanLimit = 1 + TTLTOOLSLOGIC_COALESCE_SCAN;
+
+        for (size_t eIdx = 1; (!canCoalesce) && (eIdx < scanLimit); eIdx++)
+            canCoalesce = (fixedOutput->tags.snoopAt(eIdx) == oldestTag);
+
+        if (canCoalesce)
+        {
+            fixedOutput->times.dequeue();
+            fixedOutput->levels.dequeue();
+            fixedOutput->tags.dequeue();
+        }
     }
+
+    return canCoalesce;
 }
 
 
 
 //
-// Merging of multiple FIFO outputs - Logical merger.
+// FIFO that accepts slightly out-of-order input.
+
+
+// Constructor.
+ReorderFIFO::ReorderFIFO()
+{
+    maxLateness = 0;
+    clearHeld();
+}
+
+
+// Configuration.
+
+void ReorderFIFO::setMaxLateness(int64 newLateness)
+{
+    maxLateness = (newLateness < 0) ? 0 : newLateness;
+
+    // A smaller bound may make held events releasable now.
+    releaseUntil(newestInputTime - maxLateness);
+}
+
+
+int64 ReorderFIFO::getMaxLateness()
+{
+    return maxLateness;
+}
+
+
+// Buffer reset. This discards held input as well as queued output.
+void ReorderFIFO::clearBuffer()
+{
+    LogicFIFO::clearBuffer();
+    clearHeld();
+}
+
+
+// Input processing. Input is held until it's older than the newest input by more than the lateness bound.
+void ReorderFIFO::handleInput(int64 inputTime, bool inputLevel, int inputTag)
+{
+    // If we're out of space, make room. This releases the oldest event early, so stragglers before it become late.
+    if (heldCount >= TTLTOOLSLOGIC_REORDER_SIZE)
+        releaseOldest();
+
+    // Input at or before the released time can't be placed in order anymore.
+    if (inputTime <= releasedTime)
+    {
+        L_PRINT("Input at time " << inputTime << " is later than the lateness bound; moving it to " << (releasedTime + 1) << ".");
+        inputTime = releasedTime + 1;
+        lateCount++;
+    }
+
+    if (inputTime > newestInputTime)
+        newestInputTime = inputTime;
+
+    int64 releaseTime = newestInputTime - maxLateness;
+
+    // Fast path: with nothing held, input that's already releasable goes straight through.
+    if ( (0 == heldCount) && (inputTime <= releaseTime) )
+        LogicFIFO::handleInput(inputTime, inputLevel, inputTag);
+    else
+        holdEvent(inputTime, inputLevel, inputTag);
+
+    releaseUntil(releaseTime);
+}
+
+
+void ReorderFIFO::handleInputBatch(const LogicEvent *inputEvents, int eventCount)
+{
+    for (int evIdx = 0; evIdx < eventCount; evIdx++)
+        ReorderFIFO::handleInput(inputEvents[evIdx].time, inputEvents[evIdx].level, inputEvents[evIdx].tag);
+}
+
+
+// Input processing. Input is complete up to and including newTime, so everything held up to then can be released.
+void ReorderFIFO::advanceToTime(int64 newTime)
+{
+    releaseUntil(newTime);
+}
+
+
+// Statistics.
+
+int ReorderFIFO::getHeldCount()
+{
+    return heldCount;
+}
+
+
+int64 ReorderFIFO::getLateCount()
+{
+    return lateCount;
+}
+
+
+// Checkpointing. Held input is saved as well as the parent's queued output.
+// Child class state goes ahead of the parent's, so that it can be validated before anything is overwritten.
+void ReorderFIFO::writeState(MemoryOutputStream &dest)
+{
+    dest.writeInt(LOGIC_STATE_MAGIC_REORDER);
+
+    dest.writeInt64(maxLateness);
+    dest.writeInt64(newestInputTime);
+    dest.writeInt64(releasedTime);
+    dest.writeInt64(lateCount);
+
+    dest.writeInt(heldCount);
+    for (int hIdx = 0; hIdx < heldCount; hIdx++)
+    {
+        LogicEvent &thisEvent = heldEvents[(heldFirst + hIdx) & LOGIC_REORDER_MASK];
+        dest.writeInt64(thisEvent.time);
+        dest.writeBool(thisEvent.level);
+        dest.writeInt(thisEvent.tag);
+    }
+
+    LogicFIFO::writeState(dest);
+}
+
+
+bool ReorderFIFO::readState(MemoryInputStream &source)
+{
+    // Each held event takes 13 bytes.
+    if (source.getNumBytesRemaining() < 40)
+        return false;
+    if (LOGIC_STATE_MAGIC_REORDER != source.readInt())
+        return false;
+
+    int64 newLateness = source.readInt64();
+    int64 newNewest = source.readInt64();
+    int64 newReleased = source.readInt64();
+    int64 newLateCount = source.readInt64();
+
+    int newHeldCount = source.readInt();
+    if ( (newHeldCount < 0) || (newHeldCount > TTLTOOLSLOGIC_REORDER_SIZE)
+        || (source.getNumBytesRemaining() < 13 * (int64) newHeldCount) )
+        return false;
+
+    Array<LogicEvent> newHeld;
+    for (int hIdx = 0; hIdx < newHeldCount; hIdx++)
+    {
+        int64 thisTime = source.readInt64();
+        bool thisLevel = source.readBool();
+        int thisTag = source.readInt();
+        newHeld.add(LogicEvent(thisTime, thisLevel, thisTag));
+    }
+
+    if (!LogicFIFO::readState(source))
+        return false;
+
+    maxLateness = newLateness;
+    newestInputTime = newNewest;
+    releasedTime = newReleased;
+    lateCount = newLateCount;
+
+    heldFirst = 0;
+    heldCount = newHeldCount;
+    for (int hIdx = 0; hIdx < newHeldCount; hIdx++)
+        heldEvents[hIdx] = newHeld[hIdx];
+
+    return true;
+}
+
+
+// Protected accessors.
+
+void ReorderFIFO::clearHeld()
+{
+    heldFirst = 0;
+    heldCount = 0;
+
+    newestInputTime = LOGIC_TIMESTAMP_BOGUS;
+    releasedTime = LOGIC_TIMESTAMP_BOGUS;
+    lateCount = 0;
+}
+
+
+// This inserts an event into the held list, after any held events with the same timestamp.
+// In-order input stops at the first comparison; late input walks back only as far as it's late.
+void ReorderFIFO::holdEvent(int64 inputTime, bool inputLevel, int inputTag)
+{
+    int insertIdx = heldCount;
+    while ( (insertIdx > 0) && (heldEvents[(heldFirst + insertIdx - 1) & LOGIC_REORDER_MASK].time > inputTime) )
+    {
+        heldEvents[(heldFirst + insertIdx) & LOGIC_REORDER_MASK] = heldEvents[(heldFirst + insertIdx - 1) & LOGIC_REORDER_MASK];
+        insertIdx--;
+    }
+
+    heldEvents[(heldFirst + insertIdx) & LOGIC_REORDER_MASK] = LogicEvent(inputTime, inputLevel, inputTag);
+    heldCount++;
+}
+
+
+// This moves the oldest held event to the output.
+// Later input can still have the same timestamp, but nothing earlier can be placed in order after this.
+void ReorderFIFO::releaseOldest()
+{
+    LogicEvent &thisEvent = heldEvents[heldFirst];
+
+    LogicFIFO::handleInput(thisEvent.time, thisEvent.level, thisEvent.tag);
+
+    if ((thisEvent.time - 1) > releasedTime)
+        releasedTime = thisEvent.time - 1;
+
+    heldFirst = (heldFirst + 1) & LOGIC_REORDER_MASK;
+    heldCount--;
+}
+
+
+// This releases all held events up to and including newTime, and marks output as final up to newTime.
+void ReorderFIFO::releaseUntil(int64 newTime)
+{
+    while ( (heldCount > 0) && (heldEvents[heldFirst].time <= newTime) )
+        releaseOldest();
+
+    if (newTime > releasedTime)
+        releasedTime = newTime;
+
+    advanceWatermark(releasedTime);
+}
+
+
+
+//
+// Merging of multiple FIFO outputs - Base class.
 
 // This works by pulling, to avoid needing input buffers.
-// This performs a boolean AND or OR operation on its inputs, returning a single output.
-// We're stripping input tags, since there isn't a 1:1 relation between input and output events.
+// The base class implements features shared by the multiplexer and the logical merger.
 
 
 // Constructor.
-LogicMerger::LogicMerger()
+MergerBase::MergerBase()
 {
-    mergeMode = mergeAnd;
+    useSubscription = false;
+    dirtyCount = 0;
 
-    // The parent constructor already initialized everything else.
+    clearInputList();
+    clearMergeState();
+
+    // Our output buffer was cleared by the LogicFIFO constructor, and we have no inputs yet, so nothing more to do.
+}
+
+
+// Destructor. This unsubscribes from inputs, so that they don't notify a deleted merger.
+MergerBase::~MergerBase()
+{
+    clearInputList();
 }
 
 
 // Accessors.
 
-void LogicMerger::setMergeMode(LogicMerger::MergerType newMode)
+void MergerBase::clearInputList()
 {
-    mergeMode = newMode;
+    if (useSubscription)
+        for (int inIdx = 0; inIdx < inputList.size(); inIdx++)
+            if (NULL != inputList[inIdx])
+                inputList[inIdx]->removeConsumer(this);
+
+    inputList.clear();
+    inputTags.clear();
+
+    inputRateNums.clear();
+    inputRateDens.clear();
+    inputTimeOffsets.clear();
+    inputNeedsConversion.clear();
+
+    inputIsDirty.clear();
+    dirtyInputs.clear();
+    dirtyCount = 0;
+
+    clearMergeState();
 }
 
 
-void LogicMerger::processPendingInputUntil(int64 newTime)
+// Inputs on a different sample clock can be given an exact rate ratio and offset.
+// Output time is floor(inputTime * rateNum / rateDen) + timeOffset.
+void MergerBase::addInput(LogicFIFO* newInput, int idTag, int64 rateNum, int64 rateDen, int64 timeOffset)
 {
-    bool thisOutput;
+    // Force sanity. Rates have to be positive, or events would be reordered.
+    if ( (rateNum < 1) || (rateDen < 1) )
+    {
+        L_WARN(".. WARNING - Bogus rate ratio " << rateNum << "/" << rateDen << " for merger input; using 1/1.");
+        rateNum = 1;
+        rateDen = 1;
+    }
 
-    // Scan over all inputs, pick the oldest, and process it.
-    // Only do this up to the specified time.
+    inputList.add(newInput);
+    inputTags.add(idTag);
 
-    bool hadInput = havePendingInput();
-    int64 currentTime = findNextInputTime();
+    inputRateNums.add(rateNum);
+    inputRateDens.add(rateDen);
+    inputTimeOffsets.add(timeOffset);
+    inputNeedsConversion.add( (rateNum != rateDen) || (0 != timeOffset) );
 
-// FIXME - Spammy diagnostics.
-//L_PRINT("LogicMerger advancing to " << newTime << " with " << (hadInput ? "pending input" : "no input") << " at time " << getCurrentInputTime() << ".");
+    // Preallocate a dirty-list slot, so that marking inputs dirty never allocates.
+    int newIdx = inputList.size() - 1;
+    inputIsDirty.add(false);
+    dirtyInputs.add(0);
 
-    while ( hadInput && (currentTime <= newTime) )
+    if (useSubscription && (NULL != newInput))
     {
-        // Acknowledge pending inputs.
-        advanceToTime(currentTime);
+        newInput->addConsumer(this, newIdx);
+        if (newInput->hasPendingOutput())
+            markInputDirty(newIdx);
+    }
 
-        // Build a new output event based on the last acknowledged inputs.
-        // Get the logical-AND or logical-OR of all acknowledged outputs.
-        thisOutput = (mergeMode == mergeAnd);
-        for (int inIdx = 0; inIdx < inputList.size(); inIdx++)
-            if (NULL != inputList[inIdx])
+    clearMergeState();
+}
+
+
+void MergerBase::clearBuffer()
+{
+    LogicFIFO::clearBuffer();
+
+    for (int inIdx = 0; inIdx < inputList.size(); inIdx++)
+        if (NULL != inputList[inIdx])
+            (inputList[inIdx])->clearBuffer();
+
+    // Input history was reset, so any derived merge state is stale.
+    clearMergeState();
+}
+
+
+void MergerBase::clearMergeState()
+{
+    // Nothing to do.
+}
+
+
+// Subscription mode. Instead of polling every input, only inputs that have enqueued output since they were last drained are visited.
+void MergerBase::setSubscriptionMode(bool wantSubscription)
+{
+    if (wantSubscription == useSubscription)
+        return;
+
+    useSubscription = wantSubscription;
+
+    for (int inIdx = 0; inIdx < inputList.size(); inIdx++)
+        inputIsDirty.set(inIdx, false);
+    dirtyCount = 0;
+
+    for (int inIdx = 0; inIdx < inputList.size(); inIdx++)
+        if (NULL != inputList[inIdx])
+        {
+            if (useSubscription)
             {
-                bool thisLevel = inputList[inIdx]->getLastAcknowledgedLevel();
-                switch (mergeMode)
-                {
-                case mergeAnd:
-                    thisOutput = thisOutput && thisLevel;
-                    break;
-                case mergeOr:
-                    thisOutput = thisOutput || thisLevel;
-                    break;
-                default:
-                    break;
-                }
+                inputList[inIdx]->addConsumer(this, inIdx);
+                // Inputs that already have output are active.
+                if (inputList[inIdx]->hasPendingOutput())
+                    markInputDirty(inIdx);
             }
+            else
+                inputList[inIdx]->removeConsumer(this);
+        }
+}
 
-        // Emit this output.
-        // FIXME - We're not checking to see if output actually _changed_, here.
-        enqueueOutput(currentTime, thisOutput, 0);
 
-        hadInput = havePendingInput();
-        currentTime = findNextInputTime();
-    }
+bool MergerBase::isUsingSubscription()
+{
+    return useSubscription;
+}
+
+
+// This acknowledges all input up to the specified timestamp.
+void MergerBase::advanceToTime(int64 newTime)
+{
+    // Acknowledge all events that are at or before this timestamp.
+    // Even if we picked the earliest timestamp, a source may still have several pending events at that time (zero-delay glitching).
+    int activeCount = getActiveInputCount();
+    for (int activeIdx = 0; activeIdx < activeCount; activeIdx++)
+    {
+        int inIdx = getActiveInputIndex(activeIdx);
+        if (NULL != inputList[inIdx])
+        {
+            bool wasEarly = true;
+            bool hadAcknowledged = false;
+            while ( wasEarly && (inputList[inIdx]->hasPendingOutput()) )
+                if (convertInputTime(inIdx, inputList[inIdx]->getNextOutputTime()) <= newTime)
+                {
+                    inputList[inIdx]->acknowledgeOutput();
+                    hadAcknowledged = true;
+                }
+                else
+                    wasEarly = false;
+
+            if (hadAcknowledged)
+                handleInputAcknowledged(inIdx);
+        }
+    }
+}
+
+
+bool MergerBase::havePendingInput()
+{
+    bool hadInput = false;
+
+    // This is a convenient place to drop drained inputs from the active set.
+    pruneActiveInputs();
+
+    int activeCount = getActiveInputCount();
+    for (int activeIdx = 0; activeIdx < activeCount; activeIdx++)
+    {
+        int inIdx = getActiveInputIndex(activeIdx);
+        if (NULL != inputList[inIdx])
+            if (inputList[inIdx]->hasPendingOutput())
+                hadInput = true;
+    }
+
+    // Done.
+    return hadInput;
+}
+
+
+// This finds the earliest timestamp in the still-pending input. It returns a bogus default value if there is no input, so check that first.
+int64 MergerBase::findNextInputTime()
+{
+    int64 earliestTime = LOGIC_TIMESTAMP_BOGUS;
+    bool hadInput = false;
+
+    // Identify the oldest pending timestamp and record it.
+    int activeCount = getActiveInputCount();
+    for (int activeIdx = 0; activeIdx < activeCount; activeIdx++)
+    {
+        int inIdx = getActiveInputIndex(activeIdx);
+        if (NULL != inputList[inIdx])
+            if (inputList[inIdx]->hasPendingOutput())
+            {
+                int64 thisTime = convertInputTime(inIdx, inputList[inIdx]->getNextOutputTime());
+                if ((!hadInput) || (thisTime < earliestTime))
+                    earliestTime = thisTime;
+                hadInput = true;
+            }
+    }
+// FIXME - Spammy diagnostics.
+//L_PRINT("findNextInputTime found " << (hadInput ? "input" : "no input") << ", at reported time " << earliestTime << ".");
+
+    // Done.
+    return earliestTime;
+}
+
+
+// This finds the time up to which all inputs are known to be complete (the minimum input watermark), in the output's time domain.
+// This returns a bogus default value if there are no inputs.
+int64 MergerBase::findInputWatermark()
+{
+    int64 earliestTime = LOGIC_TIMESTAMP_BOGUS;
+    bool hadInput = false;
+
+    for (int inIdx = 0; inIdx < inputList.size(); inIdx++)
+        if (NULL != inputList[inIdx])
+        {
+            int64 thisTime = inputList[inIdx]->getWatermark();
+
+            // Input is complete up to thisTime, so the next possible input is at (thisTime + 1).
+            // Anything before that converted timestamp is complete in our time domain.
+            if (inputNeedsConversion[inIdx])
+                thisTime = convertInputTime(inIdx, thisTime + 1) - 1;
+
+            if ((!hadInput) || (thisTime < earliestTime))
+                earliestTime = thisTime;
+            hadInput = true;
+        }
+
+    return earliestTime;
+}
+
+
+// This merges input up to the specified time. Inputs must be complete up to this time.
+void MergerBase::processPendingInputUntil(int64 newTime)
+{
+    processPendingInputBudgeted(newTime, 0, 0);
+}
+
+
+// Budgeted merging. This stops early at a timestamp boundary, and returns the time up to which input has been merged.
+int64 MergerBase::processPendingInputBudgeted(int64 newTime, int maxEvents, int64 deadlineTicks)
+{
+    L_PROFILE_SCOPE(profileMergerProcess)
+
+    WorkBudget budget(maxEvents, deadlineTicks);
+
+    prepareMerge();
+
+    // Scan over all inputs, pick the oldest, and process it.
+    // Only do this up to the specified time.
+
+    bool hadInput = havePendingInput();
+    int64 currentTime = findNextInputTime();
+
+// FIXME - Spammy diagnostics.
+//L_PRINT("Merger advancing to " << newTime << " with " << (hadInput ? "pending input" : "no input") << " at time " << currentTime << ".");
+
+    while ( hadInput && (currentTime <= newTime) )
+    {
+        if (budget.isExhausted())
+        {
+            // Everything before this timestamp has been merged, and nothing at it has.
+            advanceWatermark(currentTime - 1);
+            return currentTime - 1;
+        }
+
+        L_PROFILE_EVENTS(profileMergerProcess, 1)
+
+        mergeInputAt(currentTime);
+        budget.countEvent();
+
+        hadInput = havePendingInput();
+        currentTime = findNextInputTime();
+    }
+
+    // Input is complete up to newTime, so our output is too.
+    advanceWatermark(newTime);
+    return newTime;
+}
+
+
+// Merging steps. The base class doesn't produce output; it just consumes input.
+
+void MergerBase::prepareMerge()
+{
+    // Nothing to do.
+}
+
+
+void MergerBase::mergeInputAt(int64 currentTime)
+{
+    // Acknowledge pending inputs.
+    advanceToTime(currentTime);
+}
+
+
+void MergerBase::handleInputAcknowledged(int inIdx)
+{
+    // Nothing to do.
+}
+
+
+// This merges all input that's known to be complete, emitting output as early as correctness allows.
+void MergerBase::processAvailableInput()
+{
+    if (inputList.size() > 0)
+        processPendingInputUntil(findInputWatermark());
+}
+
+
+// Lazy pulling. This merges one input timestamp, first having inputs that aren't final up to that time do more work.
+// This returns false if no more output can be produced up to untilTime without more external input.
+bool MergerBase::pullMoreOutput(int64 untilTime)
+{
+    if (pulledUntilTime >= untilTime)
+        return false;
+
+    // Step to the next input timestamp, or all the way if there isn't one before then.
+    int64 stepTime = untilTime;
+    if ( havePendingInput() && (findNextInputTime() < stepTime) )
+        stepTime = findNextInputTime();
+
+    // Inputs that can't do more work on their own are fed externally, and the caller guarantees that they're complete.
+    bool hadProgress = false;
+    for (int inIdx = 0; inIdx < inputList.size(); inIdx++)
+        if (NULL != inputList[inIdx])
+        {
+            int64 inputLimit = findInputTimeLimit(inIdx, stepTime);
+            if ( (inputList[inIdx]->getWatermark() < inputLimit) && inputList[inIdx]->pullMoreOutput(inputLimit) )
+                hadProgress = true;
+        }
+
+    // Inputs may have produced earlier events, so pick the step time again next call.
+    if (hadProgress)
+        return true;
+
+    processPendingInputUntil(stepTime);
+    pulledUntilTime = stepTime;
+
+    return true;
+}
+
+
+// This finds the latest input timestamp that converts to a time at or before the specified output time.
+int64 MergerBase::findInputTimeLimit(int inIdx, int64 outputTime)
+{
+    if (!inputNeedsConversion[inIdx])
+        return outputTime;
+
+    // Estimate, then correct for rounding so that the result is exact.
+    int64 inputTime = (int64) ( ((double) (outputTime - inputTimeOffsets[inIdx])) * ((double) inputRateDens[inIdx]) / ((double) inputRateNums[inIdx]) );
+
+    while (convertInputTime(inIdx, inputTime + 1) <= outputTime)
+        inputTime++;
+    while (convertInputTime(inIdx, inputTime) > outputTime)
+        inputTime--;
+
+    return inputTime;
+}
+
+
+// This converts an input timestamp to the output's time domain, using exact integer math.
+// Output time is floor(inputTime * rateNum / rateDen) + timeOffset.
+int64 MergerBase::convertInputTime(int inIdx, int64 inputTime)
+{
+    if (!inputNeedsConversion[inIdx])
+        return inputTime;
+
+    int64 rateNum = inputRateNums[inIdx];
+    int64 rateDen = inputRateDens[inIdx];
+
+    // Split the multiplication so that large timestamps don't overflow.
+    // Use floor division, so that negative timestamps convert consistently.
+    int64 wholePart = inputTime / rateDen;
+    int64 fracPart = inputTime % rateDen;
+    if (fracPart < 0)
+    {
+        wholePart--;
+        fracPart += rateDen;
+    }
+
+    return (wholePart * rateNum) + ((fracPart * rateNum) / rateDen) + inputTimeOffsets[inIdx];
+}
+
+
+// Called by input FIFOs when they enqueue output, in subscription mode.
+void MergerBase::markInputDirty(int inIdx)
+{
+    if ( (inIdx >= 0) && (inIdx < inputIsDirty.size()) && (!inputIsDirty[inIdx]) )
+    {
+        inputIsDirty.set(inIdx, true);
+
+        // Keep the dirty list in input order, so that same-timestamp events are visited in the same order as when polling.
+        // Only a few inputs are usually active, so this is cheap.
+        int slotIdx = dirtyCount;
+        while ( (slotIdx > 0) && (dirtyInputs[slotIdx - 1] > inIdx) )
+        {
+            dirtyInputs.set(slotIdx, dirtyInputs[slotIdx - 1]);
+            slotIdx--;
+        }
+        dirtyInputs.set(slotIdx, inIdx);
+        dirtyCount++;
+    }
+}
+
+
+// These iterate over the inputs that may have pending output (all inputs, unless in subscription mode).
+
+int MergerBase::getActiveInputCount()
+{
+    return ( useSubscription ? dirtyCount : inputList.size() );
+}
+
+
+int MergerBase::getActiveInputIndex(int activeIdx)
+{
+    return ( useSubscription ? dirtyInputs[activeIdx] : activeIdx );
+}
+
+
+// This removes drained inputs from the active set, in subscription mode.
+// An input that gets more output will mark itself dirty again.
+void MergerBase::pruneActiveInputs()
+{
+    if (!useSubscription)
+        return;
+
+    int keptCount = 0;
+    for (int activeIdx = 0; activeIdx < dirtyCount; activeIdx++)
+    {
+        int inIdx = dirtyInputs[activeIdx];
+        if ( (NULL != inputList[inIdx]) && inputList[inIdx]->hasPendingOutput() )
+        {
+            dirtyInputs.set(keptCount, inIdx);
+            keptCount++;
+        }
+        else
+            inputIsDirty.set(inIdx, false);
+    }
+
+    dirtyCount = keptCount;
+}
+
+
+
+//
+// Merging of multiple FIFO outputs - Multiplexer.
+
+// This works by pulling, to avoid needing input buffers.
+// This is a multiplexer, combining several input streams into an in-order output stream with input identification tags.
+// Output events are tagged with the input stream's ID tag (input event tags are discarded).
+
+
+// Constructor.
+MuxMerger::MuxMerger()
+{
+    // Nothing more to do. The base class constructor handled everything.
+}
+
+
+// Accessors.
+
+// Merging step. This emits one output event for each input that had events at this time.
+void MuxMerger::mergeInputAt(int64 currentTime)
+{
+    // Acknowledge pending inputs.
+    advanceToTime(currentTime);
+
+    // Emit output events corresponding to the input events that just happened.
+    // Only active inputs can have had events acknowledged.
+    int activeCount = getActiveInputCount();
+    for (int activeIdx = 0; activeIdx < activeCount; activeIdx++)
+    {
+        int inIdx = getActiveInputIndex(activeIdx);
+        if (NULL != inputList[inIdx])
+        {
+            int64 thisTime = convertInputTime(inIdx, inputList[inIdx]->getLastAcknowledgedTime());
+            if (thisTime == currentTime)
+            {
+                bool thisLevel = inputList[inIdx]->getLastAcknowledgedLevel();
+                enqueueOutput(thisTime, thisLevel, inputTags[inIdx]);
+            }
+        }
+    }
+}
+
+
+
+//
+// Merging of multiple FIFO outputs - Logical merger.
+
+// This works by pulling, to avoid needing input buffers.
+// This performs a boolean AND or OR operation on its inputs, returning a single output.
+// We're stripping input tags, since there isn't a 1:1 relation between input and output events.
+
+
+// Constructor.
+LogicMerger::LogicMerger()
+{
+    mergeMode = mergeAnd;
+    levelCacheValid = false;
+    cachedHighCount = 0;
+    cachedInputCount = 0;
+
+    // The parent constructor already initialized everything else.
+}
+
+
+// Accessors.
+
+void LogicMerger::setMergeMode(LogicMerger::MergerType newMode)
+{
+    mergeMode = newMode;
+}
+
+
+void LogicMerger::clearMergeState()
+{
+    MergerBase::clearMergeState();
+
+    // Input levels or the input list changed; rebuild the cache before using it.
+    levelCacheValid = false;
+}
+
+
+// Merging steps.
+
+void LogicMerger::prepareMerge()
+{
+    if (!levelCacheValid)
+        rebuildLevelCache();
+}
+
+
+void LogicMerger::mergeInputAt(int64 currentTime)
+{
+    bool thisOutput;
+
+    // Acknowledge pending inputs. This updates cached levels for inputs that had events.
+    advanceToTime(currentTime);
+
+    // Build a new output event based on the last acknowledged inputs.
+    // Get the logical-AND or logical-OR of all acknowledged outputs.
+    switch (mergeMode)
+    {
+    case mergeAnd:
+        thisOutput = (cachedHighCount == cachedInputCount);
+        break;
+    case mergeOr:
+        thisOutput = (cachedHighCount > 0);
+        break;
+    default:
+        thisOutput = false;
+        break;
+    }
+
+    // Emit this output.
+    // FIXME - We're not checking to see if output actually _changed_, here.
+    enqueueOutput(currentTime, thisOutput, 0);
+}
+
+
+// An input's level may have changed. If the cache hasn't been built yet, it'll read the new level when it is.
+void LogicMerger::handleInputAcknowledged(int inIdx)
+{
+    if (levelCacheValid)
+        updateLevelCache(inIdx);
+}
+
+
+// This re-reads all input levels into the level cache.
+void LogicMerger::rebuildLevelCache()
+{
+    cachedLevels.clear();
+    cachedHighCount = 0;
+    cachedInputCount = 0;
+
+    for (int inIdx = 0; inIdx < inputList.size(); inIdx++)
+    {
+        bool thisLevel = false;
+        if (NULL != inputList[inIdx])
+        {
+            thisLevel = inputList[inIdx]->getLastAcknowledgedLevel();
+            cachedInputCount++;
+            if (thisLevel)
+                cachedHighCount++;
+        }
+        cachedLevels.add(thisLevel);
+    }
+
+    levelCacheValid = true;
+}
+
+
+// This updates the level cache for one input.
+void LogicMerger::updateLevelCache(int inIdx)
+{
+    if (NULL != inputList[inIdx])
+    {
+        bool thisLevel = inputList[inIdx]->getLastAcknowledgedLevel();
+        if (thisLevel != cachedLevels[inIdx])
+        {
+            cachedLevels.set(inIdx, thisLevel);
+            cachedHighCount += (thisLevel ? 1 : -1);
+        }
+    }
+}
+
+
+// Checkpointing. The merge mode is configuration, but save it so that a restore gives identical output.
+// Child class state goes ahead of the parent's, so that it can be validated before anything is overwritten.
+void LogicMerger::writeState(MemoryOutputStream &dest)
+{
+    dest.writeInt(LOGIC_STATE_MAGIC_LOGICMERGER);
+    dest.writeInt((int) mergeMode);
+
+    MergerBase::writeState(dest);
+}
+
+
+bool LogicMerger::readState(MemoryInputStream &source)
+{
+    if (source.getNumBytesRemaining() < 8)
+        return false;
+    if (LOGIC_STATE_MAGIC_LOGICMERGER != source.readInt())
+        return false;
+
+    MergerType newMode = (MergerType) source.readInt();
+
+    if (!MergerBase::readState(source))
+        return false;
+
+    mergeMode = newMode;
+
+    // Input levels are re-read from the inputs.
+    levelCacheValid = false;
+
+    return true;
+}
+
+
+
+//
+// Truth-table merging of FIFO outputs.
+
+
+// Population count of a 64-bit word, without relying on compiler intrinsics.
+static int countHighBits(uint64 bitVector)
+{
+    bitVector = bitVector - ((bitVector >> 1) & 0x5555555555555555ULL);
+    bitVector = (bitVector & 0x3333333333333333ULL) + ((bitVector >> 2) & 0x3333333333333333ULL);
+    bitVector = (bitVector + (bitVector >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+    return (int) ((bitVector * 0x0101010101010101ULL) >> 56);
+}
+
+
+// This returns a mask with the lowest "bitCount" bits set.
+static uint64 makeLowMask(int bitCount)
+{
+    if (bitCount <= 0)
+        return 0;
+    if (bitCount >= 64)
+        return ~((uint64) 0);
+    return (((uint64) 1) << bitCount) - 1;
+}
+
+
+// Constructor.
+TruthTableMerger::TruthTableMerger()
+{
+    // Default to an OR over all inputs, which is "at least one of 64".
+    functionType = functionCount;
+    countMask = ~((uint64) 0);
+    countMin = 1;
+    countMax = TTLTOOLSLOGIC_TRUTH_MAX_INPUTS;
+
+    // Empty table; everything maps to false.
+    tableInputs = 0;
+    tableIndexMask = 0;
+    tableWords.add(0);
+
+    inputBits = 0;
+    levelCacheValid = false;
+
+    // The parent constructor already initialized everything else.
+}
+
+
+// Configuration.
+
+void TruthTableMerger::setTruthTable(int newTableInputs, const Array<bool> &tableEntries)
+{
+    if (newTableInputs < 0)
+        newTableInputs = 0;
+    if (newTableInputs > TTLTOOLSLOGIC_TRUTH_MAX_TABLE_INPUTS)
+    {
+        L_WARN(".. WARNING - Truth table asked for " << newTableInputs << " inputs; limiting to " << TTLTOOLSLOGIC_TRUTH_MAX_TABLE_INPUTS << ".");
+        newTableInputs = TTLTOOLSLOGIC_TRUTH_MAX_TABLE_INPUTS;
+    }
+
+    tableInputs = newTableInputs;
+    tableIndexMask = makeLowMask(tableInputs);
+
+    int entryCount = 1 << tableInputs;
+    int wordCount = (entryCount + 63) / 64;
+
+    tableWords.clearQuick();
+    tableWords.insertMultiple(0, 0, wordCount);
+
+    // Missing entries are false.
+    int givenCount = tableEntries.size();
+    if (givenCount > entryCount)
+        givenCount = entryCount;
+    for (int entryIdx = 0; entryIdx < givenCount; entryIdx++)
+        if (tableEntries[entryIdx])
+            setTruthTableEntry(entryIdx, true);
+
+    functionType = functionTable;
+}
+
+
+void TruthTableMerger::setTruthTableEntry(int entryIdx, bool newValue)
+{
+    if ( (entryIdx < 0) || ((uint64) entryIdx > tableIndexMask) )
+        return;
+
+    uint64 thisBit = ((uint64) 1) << (entryIdx & 63);
+    uint64 thisWord = tableWords[entryIdx >> 6];
+
+    if (newValue)
+        thisWord |= thisBit;
+    else
+        thisWord &= ~thisBit;
+
+    tableWords.set(entryIdx >> 6, thisWord);
+}
+
+
+bool TruthTableMerger::getTruthTableEntry(int entryIdx)
+{
+    if ( (entryIdx < 0) || ((uint64) entryIdx > tableIndexMask) )
+        return false;
+
+    return ( 0 != ( (tableWords[entryIdx >> 6] >> (entryIdx & 63)) & 1 ) );
+}
+
+
+void TruthTableMerger::clearProductTerms()
+{
+    termCareMasks.clear();
+    termValueMasks.clear();
+    functionType = functionProducts;
+}
+
+
+void TruthTableMerger::addProductTerm(uint64 careMask, uint64 valueMask)
+{
+    // Value bits we don't care about can never match; strip them.
+    termCareMasks.add(careMask);
+    termValueMasks.add(valueMask & careMask);
+    functionType = functionProducts;
+}
+
+
+void TruthTableMerger::setCountRange(uint64 newCountMask, int minCount, int maxCount)
+{
+    countMask = newCountMask;
+    countMin = minCount;
+    countMax = maxCount;
+    functionType = functionCount;
+}
+
+
+void TruthTableMerger::setParity(uint64 newCountMask)
+{
+    countMask = newCountMask;
+    functionType = functionParity;
+}
+
+
+void TruthTableMerger::setKOfN(int inputCount, int minHigh)
+{
+    setCountRange(makeLowMask(inputCount), minHigh, TTLTOOLSLOGIC_TRUTH_MAX_INPUTS);
+}
+
+
+// Ties (exactly half high, for an even number of inputs) count as false.
+void TruthTableMerger::setMajority(int inputCount)
+{
+    setKOfN(inputCount, (inputCount / 2) + 1);
+}
+
+
+void TruthTableMerger::setXor(int inputCount)
+{
+    setParity(makeLowMask(inputCount));
+}
+
+
+void TruthTableMerger::setFunctionType(TruthTableMerger::FunctionType newType)
+{
+    functionType = newType;
+}
+
+
+TruthTableMerger::FunctionType TruthTableMerger::getFunctionType()
+{
+    return functionType;
+}
+
+
+// Accessors.
+
+void TruthTableMerger::clearMergeState()
+{
+    MergerBase::clearMergeState();
+
+    // Input levels or the input list changed; rebuild the cache before using it.
+    levelCacheValid = false;
+}
+
+
+uint64 TruthTableMerger::getInputBits()
+{
+    if (!levelCacheValid)
+        rebuildLevelCache();
+
+    return inputBits;
+}
+
+
+// Merging steps.
+
+void TruthTableMerger::prepareMerge()
+{
+    if (!levelCacheValid)
+        rebuildLevelCache();
+}
+
+
+void TruthTableMerger::mergeInputAt(int64 currentTime)
+{
+    // Acknowledge pending inputs. This updates cached levels for inputs that had events.
+    advanceToTime(currentTime);
+
+    // Emit this output.
+    // FIXME - We're not checking to see if output actually _changed_, here.
+    enqueueOutput(currentTime, evaluateFunction(), 0);
+}
+
+
+// An input's level may have changed. If the cache hasn't been built yet, it'll read the new level when it is.
+void TruthTableMerger::handleInputAcknowledged(int inIdx)
+{
+    if (levelCacheValid)
+        updateLevelCache(inIdx);
+}
+
+
+// This re-reads all input levels into the bit vector.
+void TruthTableMerger::rebuildLevelCache()
+{
+    inputBits = 0;
+
+    if (inputList.size() > TTLTOOLSLOGIC_TRUTH_MAX_INPUTS)
+        L_WARN(".. WARNING - Truth-table merger has " << inputList.size() << " inputs; only the first " << TTLTOOLSLOGIC_TRUTH_MAX_INPUTS << " are used.");
+
+    for (int inIdx = 0; (inIdx < inputList.size()) && (inIdx < TTLTOOLSLOGIC_TRUTH_MAX_INPUTS); inIdx++)
+        updateLevelCache(inIdx);
+
+    levelCacheValid = true;
+}
+
+
+// This updates the bit vector for one input.
+void TruthTableMerger::updateLevelCache(int inIdx)
+{
+    if ( (inIdx < TTLTOOLSLOGIC_TRUTH_MAX_INPUTS) && (NULL != inputList[inIdx]) )
+    {
+        uint64 thisBit = ((uint64) 1) << inIdx;
+
+        if (inputList[inIdx]->getLastAcknowledgedLevel())
+            inputBits |= thisBit;
+        else
+            inputBits &= ~thisBit;
+    }
+}
+
+
+// This evaluates the configured function on the current input bit vector.
+bool TruthTableMerger::evaluateFunction()
+{
+    switch (functionType)
+    {
+    case functionTable:
+    {
+        uint64 entryIdx = inputBits & tableIndexMask;
+        return ( 0 != ( (tableWords[(int) (entryIdx >> 6)] >> (entryIdx & 63)) & 1 ) );
+    }
+    case functionProducts:
+        for (int termIdx = 0; termIdx < termCareMasks.size(); termIdx++)
+            if ( (inputBits & termCareMasks[termIdx]) == termValueMasks[termIdx] )
+                return true;
+        return false;
+    case functionCount:
+    {
+        int highCount = countHighBits(inputBits & countMask);
+        return ( (highCount >= countMin) && (highCount <= countMax) );
+    }
+    case functionParity:
+        return ( 0 != (countHighBits(inputBits & countMask) & 1) );
+    default:
+        return false;
+    }
+}
+
+
+// Checkpointing. The function is configuration, but save it so that a restore gives identical output.
+// Child class state goes ahead of the parent's, so that it can be validated before anything is overwritten.
+void TruthTableMerger::writeState(MemoryOutputStream &dest)
+{
+    dest.writeInt(LOGIC_STATE_MAGIC_TRUTHMERGER);
+    dest.writeInt((int) functionType);
+
+    dest.writeInt(tableInputs);
+    dest.writeInt(tableWords.size());
+    for (int wordIdx = 0; wordIdx < tableWords.size(); wordIdx++)
+        dest.writeInt64((int64) tableWords[wordIdx]);
+
+    dest.writeInt(termCareMasks.size());
+    for (int termIdx = 0; termIdx < termCareMasks.size(); termIdx++)
+    {
+        dest.writeInt64((int64) termCareMasks[termIdx]);
+        dest.writeInt64((int64) termValueMasks[termIdx]);
+    }
+
+    dest.writeInt64((int64) countMask);
+    dest.writeInt(countMin);
+    dest.writeInt(countMax);
+
+    MergerBase::writeState(dest);
+}
+
+
+bool TruthTableMerger::readState(MemoryInputStream &source)
+{
+    if (source.getNumBytesRemaining() < 16)
+        return false;
+    if (LOGIC_STATE_MAGIC_TRUTHMERGER != source.readInt())
+        return false;
+
+    FunctionType newType = (FunctionType) source.readInt();
+
+    int newTableInputs = source.readInt();
+    int wordCount = source.readInt();
+    if ( (newTableInputs < 0) || (newTableInputs > TTLTOOLSLOGIC_TRUTH_MAX_TABLE_INPUTS)
+        || (wordCount != ((1 << newTableInputs) + 63) / 64)
+        || (source.getNumBytesRemaining() < 8 * (int64) wordCount + 4) )
+        return false;
+
+    Array<uint64> newWords;
+    for (int wordIdx = 0; wordIdx < wordCount; wordIdx++)
+        newWords.add((uint64) source.readInt64());
+
+    int termCount = source.readInt();
+    if ( (termCount < 0) || (source.getNumBytesRemaining() < 16 * (int64) termCount + 16) )
+        return false;
+
+    Array<uint64> newCareMasks;
+    Array<uint64> newValueMasks;
+    for (int termIdx = 0; termIdx < termCount; termIdx++)
+    {
+        newCareMasks.add((uint64) source.readInt64());
+        newValueMasks.add((uint64) source.readInt64());
+    }
+
+    uint64 newCountMask = (uint64) source.readInt64();
+    int newCountMin = source.readInt();
+    int newCountMax = source.readInt();
+
+    if (!MergerBase::readState(source))
+        return false;
+
+    functionType = newType;
+    tableInputs = newTableInputs;
+    tableIndexMask = makeLowMask(tableInputs);
+    tableWords = newWords;
+    termCareMasks = newCareMasks;
+    termValueMasks = newValueMasks;
+    countMask = newCountMask;
+    countMin = newCountMin;
+    countMax = newCountMax;
+
+    // Input levels are re-read from the inputs.
+    levelCacheValid = false;
+
+    return true;
+}
+
+
+
+//
+// Demultiplexing of a tagged event stream by tag - Tag outputs.
+
+
+// Constructor.
+TagDemuxOutput::TagDemuxOutput(TagDemux* newOwner)
+{
+    ownerDemux = newOwner;
+}
+
+
+// Lazy pulling. Anything we can output comes from the demultiplexer's input, so the demultiplexer does the pulling.
+// If it doesn't have a pull source either, then it's fed externally, and the caller guarantees that it's complete.
+bool TagDemuxOutput::pullMoreOutput(int64 untilTime)
+{
+    if (NULL == ownerDemux)
+        return false;
+
+    return ownerDemux->pullMoreOutput(untilTime);
+}
+
+
+
+//
+// Demultiplexing of a tagged event stream by tag.
+
+
+// Constructor.
+TagDemux::TagDemux()
+{
+    unroutedCount = 0;
+}
+
+
+// Configuration.
+
+LogicFIFO* TagDemux::addTagOutput(int outputTag)
+{
+    if ( (outputTag < 0) || (outputTag >= TTLTOOLSLOGIC_DEMUX_MAX_TAGS) )
+    {
+        L_WARN(".. WARNING - Tag " << outputTag << " is out of range for demultiplexing.");
+        return NULL;
+    }
+
+    LogicFIFO* result = getTagOutput(outputTag);
+
+    if (NULL == result)
+    {
+        result = tagOutputs.add(new TagDemuxOutput(this));
+        result->setDebugID(outputTag);
+        // Output so far is complete up to our watermark.
+        result->advanceToTime(getWatermark());
+        tagOutputIDs.add(outputTag);
+
+        while (tagTable.size() <= outputTag)
+            tagTable.add(NULL);
+        tagTable.set(outputTag, result);
+    }
+
+    return result;
+}
+
+
+LogicFIFO* TagDemux::getTagOutput(int outputTag)
+{
+    if ( (outputTag < 0) || (outputTag >= tagTable.size()) )
+        return NULL;
+
+    return tagTable.getUnchecked(outputTag);
+}
+
+
+void TagDemux::clearTagOutputs()
+{
+    tagTable.clear();
+    tagOutputIDs.clear();
+    tagOutputs.clear();
+}
+
+
+// Buffer reset. This clears tag outputs as well as our own.
+void TagDemux::clearBuffer()
+{
+    LogicFIFO::clearBuffer();
+
+    for (int outIdx = 0; outIdx < tagOutputs.size(); outIdx++)
+        tagOutputs[outIdx]->clearBuffer();
+
+    unroutedCount = 0;
+}
+
+
+// Input processing. Each event goes to its tag's output, or to our own output if its tag doesn't have one.
+void TagDemux::handleInput(int64 inputTime, bool inputLevel, int inputTag)
+{
+    LogicFIFO* destFIFO = NULL;
+    // Casting to unsigned also rejects negative tags.
+    if (((unsigned) inputTag) < ((unsigned) tagTable.size()))
+        destFIFO = tagTable.getUnchecked(inputTag);
+
+    if (NULL != destFIFO)
+    {
+        destFIFO->LogicFIFO::handleInput(inputTime, inputLevel, inputTag);
+
+        // Our own output can't get anything earlier than this either.
+        setPrevInput(inputTime, inputLevel, inputTag);
+        advanceWatermark(inputTime - 1);
+    }
+    else
+    {
+        LogicFIFO::handleInput(inputTime, inputLevel, inputTag);
+        unroutedCount++;
+    }
+}
+
+
+void TagDemux::handleInputBatch(const LogicEvent *inputEvents, int eventCount)
+{
+    for (int evIdx = 0; evIdx < eventCount; evIdx++)
+        TagDemux::handleInput(inputEvents[evIdx].time, inputEvents[evIdx].level, inputEvents[evIdx].tag);
+}
+
+
+// Input processing. Input is complete up to newTime for every tag.
+void TagDemux::advanceToTime(int64 newTime)
+{
+    for (int outIdx = 0; outIdx < tagOutputs.size(); outIdx++)
+        tagOutputs[outIdx]->advanceToTime(newTime);
+
+    LogicFIFO::advanceToTime(newTime);
+}
+
+
+// Input processing. This pulls every event up to newTime from the source and routes it.
+void TagDemux::pullFromFIFOUntil(LogicFIFO *source, int64 newTime)
+{
+    pullAllFromFIFOUntil(source, newTime);
+}
+
+
+// Statistics.
+
+int64 TagDemux::getUnroutedCount()
+{
+    return unroutedCount;
+}
+
+
+// Checkpointing. Each tag output's state is saved in the order the outputs were added.
+// Child class state goes ahead of the parent's, so that it can be validated before anything is overwritten.
+void TagDemux::writeState(MemoryOutputStream &dest)
+{
+    dest.writeInt(LOGIC_STATE_MAGIC_TAGDEMUX);
+    dest.writeInt64(unroutedCount);
+
+    dest.writeInt(tagOutputs.size());
+    for (int outIdx = 0; outIdx < tagOutputs.size(); outIdx++)
+    {
+        dest.writeInt(tagOutputIDs[outIdx]);
+        tagOutputs[outIdx]->writeState(dest);
+    }
+
+    LogicFIFO::writeState(dest);
+}
+
+
+bool TagDemux::readState(MemoryInputStream &source)
+{
+    if (source.getNumBytesRemaining() < 16)
+        return false;
+    if (LOGIC_STATE_MAGIC_TAGDEMUX != source.readInt())
+        return false;
+
+    int64 newUnroutedCount = source.readInt64();
+
+    int outputCount = source.readInt();
+    if (outputCount != tagOutputs.size())
+        return false;
+
+    // Check every tag output's saved state against that output before restoring any of them.
+    Array<int64> outputStarts;
+    bool isOk = true;
+
+    for (int outIdx = 0; isOk && (outIdx < outputCount); outIdx++)
+    {
+        isOk = (source.getNumBytesRemaining() >= 4) && (source.readInt() == tagOutputIDs[outIdx]);
+        outputStarts.add(source.getPosition());
+        isOk = isOk && tagOutputs[outIdx]->skipState(source);
+    }
+
+    if (!isOk)
+        return false;
+
+    if (!LogicFIFO::readState(source))
+        return false;
+
+    // Everything checked out. Go back and restore the tag outputs.
+    int64 endPosition = source.getPosition();
+    for (int outIdx = 0; outIdx < outputCount; outIdx++)
+    {
+        source.setPosition(outputStarts[outIdx]);
+        tagOutputs[outIdx]->readState(source);
+    }
+    source.setPosition(endPosition);
+
+    unroutedCount = newUnroutedCount;
+
+    return true;
 }
 
 
@@ -8,17 +8,124 @@
 // Making this a power of 2 _should_ be faster but isn't vital.
 #define TTLTOOLSLOGIC_EVENT_BUF_SIZE 16384
 
+// Magic constant: how far past the oldest queued event to look for a later event on the same tag when coalescing.
+#define TTLTOOLSLOGIC_COALESCE_SCAN 8
+
+// Magic constant: default byte capacity of a FIFO's compact storage buffer, if enabled.
+// Typical TTL traffic takes 2-4 bytes per event in compact storage, so this holds 2-4 times as many events as the
+// fixed buffer. The fixed buffer (13 bytes per event, about 213 kB) is freed in compact mode, so this replaces it.
+#define TTLTOOLSLOGIC_COMPACT_BUF_BYTES 131072
+
+// Magic constants: input limits for truth-table merging.
+// Input levels are packed into a 64-bit word. Full lookup tables take 2^N bits, so they're limited to fewer inputs.
+#define TTLTOOLSLOGIC_TRUTH_MAX_INPUTS 64
+#define TTLTOOLSLOGIC_TRUTH_MAX_TABLE_INPUTS 16
+
+// Magic constant: maximum number of events held back for reordering.
+// This should be a power of 2. If it fills, the oldest held event is released early.
+#define TTLTOOLSLOGIC_REORDER_SIZE 256
+
+// Magic constant: tags at or above this can't be given their own demultiplexer output.
+// The tag lookup table is sized to the largest tag actually used, not to this.
+#define TTLTOOLSLOGIC_DEMUX_MAX_TAGS 65536
+
+// Magic constant: how many events budgeted processing calls handle between checks of the clock against their deadline.
+#define TTLTOOLSLOGIC_BUDGET_CLOCK_INTERVAL 16
+
+// Magic constant: number of events pulled from a source FIFO per batch.
+#define TTLTOOLSLOGIC_BATCH_SIZE 256
+
 
 // Class declarations.
 namespace TTLTools
 {
+	class MergerBase;
+	class TagDemux;
+
+	// One TTL event, for passing lists of events around.
+	// Nothing in here is dynamically allocated, so copy-by-value is fine.
+	class COMMON_LIB LogicEvent
+	{
+	public:
+		int64 time;
+		bool level;
+		int tag;
+
+		LogicEvent() { time = 0; level = false; tag = 0; }
+		LogicEvent(int64 newTime, bool newLevel, int newTag = 0) { time = newTime; level = newLevel; tag = newTag; }
+	};
+
+	// Work budget for resumable processing calls. A zero limit means "no limit".
+	// The deadline is in Time::getHighResolutionTicks() units, and is only checked every few events, since reading the
+	// clock isn't free. At least one event is always allowed, so repeated calls always make progress.
+	// NOTE - This should NOT use the "COMMON_LIB" macro; it's entirely inline.
+	class WorkBudget
+	{
+	public:
+		WorkBudget(int newMaxEvents, int64 newDeadlineTicks)
+		{
+			maxEvents = newMaxEvents;
+			deadlineTicks = newDeadlineTicks;
+			eventCount = 0;
+			pastDeadline = false;
+		}
+
+		bool isExhausted()
+		{
+			if ( (maxEvents > 0) && (eventCount >= maxEvents) )
+				return true;
+			if ( (deadlineTicks > 0) && (!pastDeadline) && (eventCount > 0) && (0 == (eventCount % TTLTOOLSLOGIC_BUDGET_CLOCK_INTERVAL)) )
+				pastDeadline = (Time::getHighResolutionTicks() >= deadlineTicks);
+			return pastDeadline;
+		}
+
+		void countEvent() { eventCount++; }
+
+	protected:
+		int maxEvents;
+		int64 deadlineTicks;
+		int eventCount;
+		bool pastDeadline;
+	};
+
 	// Parent class for buffered TTL handling.
+	// Fixed-size storage for queued output, at 13 bytes per event.
+	// NOTE - This is large. LogicFIFO puts it on the heap and only allocates it when compact storage isn't selected.
+	class FixedEventBuf
+	{
+	public:
+		CircBuf<int64,TTLTOOLSLOGIC_EVENT_BUF_SIZE> times;
+		CircBuf<bool,TTLTOOLSLOGIC_EVENT_BUF_SIZE> levels;
+		CircBuf<int,TTLTOOLSLOGIC_EVENT_BUF_SIZE> tags;
+	};
+
+
 	class COMMON_LIB LogicFIFO
 	{
 	public:
+		// What to do when the output buffer is full.
+		// All policies are O(1) per event and never allocate.
+		enum OverloadPolicy
+		{
+			// Discard the new event. This can leave a line stuck in the wrong state downstream.
+			overloadDropNewest = 0,
+			// Discard the oldest queued event if a later queued event on the same tag supersedes it, then keep the new event.
+			// The final level of every line is preserved; only the oldest transitions are lost.
+			// NOTE - For multiplexed streams, if no superseding event is found within TTLTOOLSLOGIC_COALESCE_SCAN events
+			// (one event in compact storage), the new event is discarded instead.
+			overloadCoalesceOldest = 1,
+			// If the new event and the newest queued event on the same tag form a pulse, discard both.
+			// If the new event doesn't change the level, discard it. Otherwise, coalesce as above.
+			overloadDropGlitchPairs = 2
+		};
+
 		// Constructor.
 		LogicFIFO();
-		// Default destructor is fine.
+		// Destructor. This is virtual, since derived classes may need to detach from other objects.
+		virtual ~LogicFIFO();
+		// FIFOs own their output buffer, so they can't be copied directly. Use getCopyByValue() instead.
+		LogicFIFO(const LogicFIFO &) = delete;
+		LogicFIFO& operator=(const LogicFIFO &) = delete;
 
 
 		// Accessors.
@@ -27,17 +134,46 @@ namespace TTLTools
 		virtual void clearBuffer();
 		virtual void setPrevInput(int64 resetTime, bool newInput, int newTag = 0);
 
+		// Compact storage selection. This delta-encodes queued output, trading some CPU time for holding more events.
+		// This should be called during setup, since it allocates. Pending output is kept; anything that doesn't fit
+		// is handled by the overload policy.
+		// NOTE - Compact storage replaces the fixed-size buffer, which is freed; switching back reallocates it.
+		void setCompactStorage(bool wantCompact, size_t byteCapacity = TTLTOOLSLOGIC_COMPACT_BUF_BYTES);
+		bool isUsingCompactStorage();
+
+		// Overload handling. The overload flag is set whenever an event is discarded or coalesced.
+		void setOverloadPolicy(OverloadPolicy newPolicy);
+		OverloadPolicy getOverloadPolicy();
+		bool hasOverloaded();
+		int64 getOverloadCount();
+		void clearOverloadFlag();
+
 		// Input processing.
 		virtual void handleInput(int64 inputTime, bool inputLevel, int inputTag = 0);
 		virtual void advanceToTime(int64 newTime);
 
+		// Batch input. This is equivalent to calling handleInput() for each event in order, but makes one virtual call per block.
+		// The base version calls handleInput() for each event, unless this is a plain LogicFIFO. Child classes that
+		// override handleInput() should override this too, to avoid the per-event virtual calls.
+		virtual void handleInputBatch(const LogicEvent *inputEvents, int eventCount);
+
 		// Alternate input method: Have it pull from another FIFO the same way merger objects do.
-		// This calls handleInput() to process events that it pulls.
+		// This calls handleInputBatch() to process events that it pulls.
 		virtual void pullFromFIFOUntil(LogicFIFO *source, int64 newTime);
 
+		// Lazy pulling. With a pull source set, pullMoreOutput() pulls one timestamp's worth of input from it (having the
+		// source do more work first, if needed), and readNextOutputUntil() calls it only until output is available.
+		// Inputs at the top of the pipeline must be complete up to the requested time, as with pullFromFIFOUntil().
+		// NOTE - Don't also call pullFromFIFOUntil() on a FIFO that has a pull source.
+		void setPullSource(LogicFIFO *newSource);
+		LogicFIFO* getPullSource();
+		// This returns false if no more output can be produced up to untilTime without more external input.
+		virtual bool pullMoreOutput(int64 untilTime);
+
 		// State accessors.
 
 		bool hasPendingOutput();
+		size_t getPendingOutputCount();
 		int64 getNextOutputTime();
 		bool getNextOutputLevel();
 		int getNextOutputTag();
@@ -46,6 +182,16 @@ namespace TTLTools
 		// This acknowledges and discards output up to and including the specified timestamp.
 		void drainOutputUntil(int64 newTime);
 
+		// Batch output. This copies and acknowledges up to maxEvents queued events (optionally only those up to and
+		// including untilTime), and returns the number of events copied.
+		int readOutputBatch(LogicEvent *destEvents, int maxEvents);
+		int readOutputBatchUntil(LogicEvent *destEvents, int maxEvents, int64 untilTime);
+
+		// Single-event output. This copies and acknowledges the next queued event, returning false if there isn't one.
+		// The "until" version only returns events up to and including untilTime, and pulls more output if needed.
+		bool readNextOutput(LogicEvent &destEvent);
+		bool readNextOutputUntil(LogicEvent &destEvent, int64 untilTime);
+
 		int64 getLastInputTime();
 		bool getLastInputLevel();
 		int getLastInputTag();
@@ -54,16 +200,33 @@ namespace TTLTools
 		bool getLastAcknowledgedLevel();
 		int getLastAcknowledgedTag();
 
+		// Output watermark. No further output will be enqueued with a timestamp at or before this time.
+		// Input is considered complete up to the time passed to advanceToTime(), or up to just before the last input event.
+		int64 getWatermark();
+
 		// Copy-by-value accessor. This is used for splitting output.
 		LogicFIFO* getCopyByValue();
 
 		// This makes debugging messages easier to tell apart.
 		void setDebugID(int newID);
 
+		// Checkpointing. This saves or restores all processing state, including queued output.
+		// Input pointers and debug IDs are not saved; the caller has to rebuild the pipeline topology before restoring.
+		// Restoring returns false (leaving state unchanged) if the data is truncated or is for a different class.
+		virtual void writeState(MemoryOutputStream &dest);
+		virtual bool readState(MemoryInputStream &source);
+		// This checks saved plain FIFO state the way readState() would for this FIFO, and skips past it without restoring it.
+		bool skipState(MemoryInputStream &source);
+
+		// Convenience wrappers for checkpointing to/from a flat buffer.
+		void saveState(MemoryBlock &dest);
+		bool loadState(const MemoryBlock &source);
+
 	protected:
-		CircBuf<int64,TTLTOOLSLOGIC_EVENT_BUF_SIZE> pendingOutputTimes;
-		CircBuf<bool,TTLTOOLSLOGIC_EVENT_BUF_SIZE> pendingOutputLevels;
-		CircBuf<int,TTLTOOLSLOGIC_EVENT_BUF_SIZE> pendingOutputTags;
+		// Storage for queued output. Exactly one of these is allocated, depending on whether compact storage is selected.
+		FixedEventBuf* fixedOutput;
+		CompactEventBuf compactOutput;
+		bool useCompactOutput;
 
 		int64 prevInputTime;
 		bool prevInputLevel;
@@ -73,9 +236,146 @@ namespace TTLTools
 		bool prevAcknowledgedLevel;
 		int prevAcknowledgedTag;
 
+		int64 watermarkTime;
+
+		// Lazy pulling state. Input has been pulled from the pull source up to pulledUntilTime.
+		LogicFIFO* pullSource;
+		int64 pulledUntilTime;
+
+		OverloadPolicy overloadPolicy;
+		int64 overloadCount;
+
+		// Mergers that want to be told when we enqueue output, and the input slot we occupy in each.
+		// This is only used by mergers in subscription mode.
+		Array<MergerBase*> consumerList;
+		Array<int> consumerSlots;
+
 		int debugID;
 
+		// Subscription management. Only mergers call these.
+		friend class MergerBase;
+		void addConsumer(MergerBase* newConsumer, int inputSlot);
+		void removeConsumer(MergerBase* oldConsumer);
+
+		// This moves the watermark forwards (never backwards).
+		void advanceWatermark(int64 newTime);
+
+		// This checks a saved event count against our storage and the bytes left to read.
+		bool checkSavedEventCount(int eventCount, MemoryInputStream &source);
+
+		// This is pullFromFIFOUntil() without merging events that have the same timestamp, for streams where those
+		// events are distinct (such as multiplexed streams).
+		void pullAllFromFIFOUntil(LogicFIFO *source, int64 newTime);
+
+		// This copies input events to the output, as the FIFO's handleInputBatch() does. It's for pass-through child classes.
+		void copyInputBatch(const LogicEvent *inputEvents, int eventCount);
+
 		void enqueueOutput(int64 newTime, bool newLevel, int newTag);
+		// This enqueues output without checking it against the most recent input (for output that was held back).
+		void enqueueOutputUnchecked(int64 newTime, bool newLevel, int newTag);
+		// This stores an event in whichever output buffer is active, without any other bookkeeping.
+		// This returns false (discarding the event) if the buffer is full.
+		bool storeOutput(int64 newTime, bool newLevel, int newTag);
+		// This tells subscribed mergers that we have output. Anything that calls storeOutput() directly has to call this.
+		void notifyConsumers();
+
+		// Overload handling. This applies the overload policy to an event that didn't fit.
+		void handleOverload(int64 newTime, bool newLevel, int newTag);
+		// This discards the oldest queued event if a later queued event on the same tag supersedes it.
+		bool coalesceOldestOutput();
+	};
+
+
+	// Lazy range over a FIFO's output up to some time, for range-based "for" loops.
+	// Events are read with readNextOutputUntil() as the loop advances, so a loop that stops early leaves later output
+	// unread, and, if the FIFO has a pull source, not yet computed.
+	// NOTE - This should NOT use the "COMMON_LIB" macro; it's entirely inline.
+	class LogicOutputRange
+	{
+	public:
+		class Iterator
+		{
+		public:
+			Iterator(LogicOutputRange *newRange) { range = newRange; }
+
+			const LogicEvent &operator*() const { return range->thisEvent; }
+			Iterator &operator++() { range->fetchNext(); return *this; }
+			bool operator!=(const Iterator &other) const { return isAtEnd() != other.isAtEnd(); }
+
+		protected:
+			LogicOutputRange *range;
+
+			bool isAtEnd() const { return (NULL == range) || (!range->haveEvent); }
+		};
+
+		LogicOutputRange(LogicFIFO *newSource, int64 newUntilTime)
+		{
+			source = newSource;
+			untilTime = newUntilTime;
+			haveEvent = false;
+		}
+
+		Iterator begin() { fetchNext(); return Iterator(this); }
+		Iterator end() { return Iterator(NULL); }
+
+	protected:
+		LogicFIFO *source;
+		int64 untilTime;
+		LogicEvent thisEvent;
+		bool haveEvent;
+
+		void fetchNext() { haveEvent = (NULL != source) && source->readNextOutputUntil(thisEvent, untilTime); }
+	};
+
+
+	// FIFO that accepts slightly out-of-order input.
+	// Input is held back until it's older than the newest input seen by more than the lateness bound, and is then
+	// released in time order. In-order input is appended without searching; out-of-order input is insertion-sorted
+	// from the newest end, so the cost scales with how late it is. Events with equal timestamps keep their arrival order.
+	// Input that arrives after its time has already been released is clamped to just after the released time and counted.
+	class COMMON_LIB ReorderFIFO : public LogicFIFO
+	{
+	public:
+		// Constructor.
+		ReorderFIFO();
+		// Default destructor is fine.
+
+		// Configuration. Lateness is in samples; zero passes input straight through.
+		void setMaxLateness(int64 newLateness);
+		int64 getMaxLateness();
+
+		// Setup.
+		void clearBuffer() override;
+
+		// Input processing.
+		// Advancing to a time releases everything held up to that time, since input is complete up to it.
+		void handleInput(int64 inputTime, bool inputLevel, int inputTag = 0) override;
+		void handleInputBatch(const LogicEvent *inputEvents, int eventCount) override;
+		void advanceToTime(int64 newTime) override;
+
+		// Statistics.
+		int getHeldCount();
+		int64 getLateCount();
+
+		void writeState(MemoryOutputStream &dest) override;
+		bool readState(MemoryInputStream &source) override;
+
+	protected:
+		// Held events, sorted by time. This is a ring buffer; heldFirst is the oldest.
+		LogicEvent heldEvents[TTLTOOLSLOGIC_REORDER_SIZE];
+		int heldFirst;
+		int heldCount;
+
+		int64 maxLateness;
+		int64 newestInputTime;
+		// Everything at or before this time has been released.
+		int64 releasedTime;
+		int64 lateCount;
+
+		void clearHeld();
+		void holdEvent(int64 inputTime, bool inputLevel, int inputTag);
+		void releaseOldest();
+		void releaseUntil(int64 newTime);
 	};
 
 
@@ -87,7 +387,8 @@ namespace TTLTools
 	public:
 		// Constructor.
 		MergerBase();
-		// Default destructor is fine.
+		// Destructor. This unsubscribes from inputs.
+		~MergerBase() override;
 
 		// Accessors.
 		// NOTE - Do not call the LogicFIFO input accessors. Call findNextInputTime() and advanceToTime() instead.
@@ -95,18 +396,77 @@ namespace TTLTools
 
 		void clearInputList();
 		// Whether id tags are used as event tags is up to the child class.
-		void addInput(LogicFIFO* newInput, int idTag = 0);
+		// Inputs on a different sample clock can be given an exact rate ratio and offset. Input timestamps are
+		// converted to output timestamps as: floor(inputTime * rateNum / rateDen) + timeOffset.
+		void addInput(LogicFIFO* newInput, int idTag = 0, int64 rateNum = 1, int64 rateDen = 1, int64 timeOffset = 0);
 
 		void clearBuffer() override;
 		virtual void clearMergeState();
 
+		// Subscription mode. Instead of polling every input, only inputs that have enqueued output since they
+		// were last drained are visited. Idle inputs cost nothing. This should be set up before processing starts.
+		void setSubscriptionMode(bool wantSubscription);
+		bool isUsingSubscription();
+
 		// This finds the earliest timestamp in the still-pending input. It returns a bogus default value if there is no input, so check that first.
+		// This is in the output's time domain.
 		bool havePendingInput();
 		int64 findNextInputTime();
 
+		// This finds the time up to which all inputs are known to be complete (the minimum input watermark), in the output's time domain.
+		int64 findInputWatermark();
+
+		// This merges input up to the specified time. Inputs must be complete up to this time.
+		virtual void processPendingInputUntil(int64 newTime);
+		// Budgeted merging. This stops early, at a timestamp boundary, once it has merged "maxEvents" input timestamps or
+		// passed the deadline (see WorkBudget). This returns the time up to which input has been merged; output is final
+		// up to that time. Call this again (or call processPendingInputUntil()) to continue.
+		int64 processPendingInputBudgeted(int64 newTime, int maxEvents, int64 deadlineTicks = 0);
+		// This merges all input that's known to be complete, emitting output as early as correctness allows.
+		void processAvailableInput();
+
+		// Lazy pulling. Mergers pull from their inputs, rather than from a pull source. This merges one input timestamp,
+		// first having inputs that aren't final up to that time do more work.
+		bool pullMoreOutput(int64 untilTime) override;
+
 	protected:
 		Array<LogicFIFO*> inputList;
 		Array<int> inputTags;
+
+		// Clock domain conversion for each input. Inputs on the output clock skip the conversion.
+		Array<int64> inputRateNums;
+		Array<int64> inputRateDens;
+		Array<int64> inputTimeOffsets;
+		Array<bool> inputNeedsConversion;
+
+		// This converts an input timestamp to the output's time domain, using exact integer math.
+		int64 convertInputTime(int inIdx, int64 inputTime);
+		// This finds the latest input timestamp that converts to a time at or before the specified output time.
+		int64 findInputTimeLimit(int inIdx, int64 outputTime);
+
+		// Subscription mode state. "dirtyInputs" is preallocated to the number of inputs, to avoid allocation while processing.
+		bool useSubscription;
+		Array<bool> inputIsDirty;
+		Array<int> dirtyInputs;
+		int dirtyCount;
+
+		// Called by input FIFOs when they enqueue output.
+		friend class LogicFIFO;
+		void markInputDirty(int inIdx);
+
+		// These iterate over the inputs that may have pending output (all inputs, unless in subscription mode).
+		int getActiveInputCount();
+		int getActiveInputIndex(int activeIdx);
+		// This removes drained inputs from the active set, in subscription mode.
+		void pruneActiveInputs();
+
+		// Merging steps. prepareMerge() is called at the start of each merging call. mergeInputAt() acknowledges all
+		// input at the specified time (the earliest pending input time) and emits the corresponding output.
+		virtual void prepareMerge();
+		virtual void mergeInputAt(int64 currentTime);
+		// This is called by advanceToTime() for each input that had events acknowledged, whoever called it. Child classes
+		// that cache input levels update them here, since a drained input may leave the active set before it's merged.
+		virtual void handleInputAcknowledged(int inIdx);
 	};
 
 
@@ -124,9 +484,8 @@ namespace TTLTools
 		// Accessors.
 		// NOTE - Do not call the LogicFIFO input accessors. Call processPendingInput() instead.
 
-		void processPendingInputUntil(int64 newTime);
-
 	protected:
+		void mergeInputAt(int64 currentTime) override;
 	};
 
 
@@ -151,10 +510,182 @@ namespace TTLTools
 		// NOTE - Do not call the LogicFIFO input accessors. Call processPendingInput() instead.
 
 		void setMergeMode(MergerType newMode);
-		void processPendingInputUntil(int64 newTime);
+
+		void writeState(MemoryOutputStream &dest) override;
+		bool readState(MemoryInputStream &source) override;
+
+		void clearMergeState() override;
 
 	protected:
 		MergerType mergeMode;
+
+		// Cached input levels. Only inputs that were advanced need to be re-checked for each output event.
+		Array<bool> cachedLevels;
+		int cachedHighCount;
+		int cachedInputCount;
+		bool levelCacheValid;
+
+		void rebuildLevelCache();
+		void updateLevelCache(int inIdx);
+
+		void prepareMerge() override;
+		void mergeInputAt(int64 currentTime) override;
+		void handleInputAcknowledged(int inIdx) override;
+	};
+
+
+	// Merging of multiple FIFO outputs.
+	// This works by pulling, to avoid needing input buffers.
+	// This evaluates an arbitrary boolean function of up to TTLTOOLSLOGIC_TRUTH_MAX_INPUTS inputs, returning a single output.
+	// Input levels are kept as a bit vector (input N is bit N), updated only for inputs that changed, so each event is O(1).
+	// We're stripping input tags, since there isn't a 1:1 relation between input and output events.
+	class COMMON_LIB TruthTableMerger : public MergerBase
+	{
+	public:
+		enum FunctionType
+		{
+			// Output is looked up from a table indexed by the input bit vector. Up to TTLTOOLSLOGIC_TRUTH_MAX_TABLE_INPUTS inputs.
+			functionTable = 0,
+			// Output is true if any product term matches: (inputBits & careMask) == valueMask. "A and not B" is one term.
+			functionProducts = 1,
+			// Output is true if the number of high inputs among the counted inputs is between minCount and maxCount.
+			// This covers k-of-n, majority, "exactly one", and so forth.
+			functionCount = 2,
+			// Output is the exclusive-OR of the counted inputs.
+			functionParity = 3
+		};
+
+		// Constructor.
+		TruthTableMerger();
+		// Default destructor is fine.
+
+		// Configuration.
+		// Inputs past TTLTOOLSLOGIC_TRUTH_MAX_INPUTS are treated as low.
+
+		// Lookup table. Entry N is the output for input bit vector N. Table size is 2^tableInputs.
+		// Inputs at or past "tableInputs" are ignored in table mode.
+		void setTruthTable(int tableInputs, const Array<bool> &tableEntries);
+		void setTruthTableEntry(int entryIdx, bool newValue);
+		bool getTruthTableEntry(int entryIdx);
+
+		// Sum of products. This also sets the function type.
+		void clearProductTerms();
+		void addProductTerm(uint64 careMask, uint64 valueMask);
+
+		// Counting. This also sets the function type. "countMask" selects which inputs are counted.
+		void setCountRange(uint64 countMask, int minCount, int maxCount);
+		void setParity(uint64 countMask);
+
+		// Convenience functions for common cases. These apply to inputs 0..(inputCount-1).
+		void setKOfN(int inputCount, int minHigh);
+		void setMajority(int inputCount);
+		void setXor(int inputCount);
+
+		void setFunctionType(FunctionType newType);
+		FunctionType getFunctionType();
+
+		// Accessors.
+		// NOTE - Do not call the LogicFIFO input accessors. Call processPendingInput() instead.
+
+		uint64 getInputBits();
+
+		void writeState(MemoryOutputStream &dest) override;
+		bool readState(MemoryInputStream &source) override;
+
+		void clearMergeState() override;
+
+	protected:
+		FunctionType functionType;
+
+		// Lookup table, packed 64 entries per word.
+		int tableInputs;
+		uint64 tableIndexMask;
+		Array<uint64> tableWords;
+
+		// Product terms.
+		Array<uint64> termCareMasks;
+		Array<uint64> termValueMasks;
+
+		// Counting.
+		uint64 countMask;
+		int countMin;
+		int countMax;
+
+		// Cached input levels.
+		uint64 inputBits;
+		bool levelCacheValid;
+
+		void rebuildLevelCache();
+		void updateLevelCache(int inIdx);
+		bool evaluateFunction();
+
+		void prepareMerge() override;
+		void mergeInputAt(int64 currentTime) override;
+		void handleInputAcknowledged(int inIdx) override;
+	};
+
+
+	// One tag's output FIFO from a TagDemux.
+	// Lazy pulls are forwarded to the demultiplexer, since it's the only thing that can produce more output for this.
+	class COMMON_LIB TagDemuxOutput : public LogicFIFO
+	{
+	public:
+		// Constructor.
+		TagDemuxOutput(TagDemux* newOwner);
+		// Default destructor is fine.
+
+		// Lazy pulling. This has the demultiplexer pull from its own pull source, and ignores this FIFO's pull source.
+		bool pullMoreOutput(int64 untilTime) override;
+
+	protected:
+		TagDemux* ownerDemux;
+	};
+
+
+	// Demultiplexing of a tagged event stream (such as MuxMerger output) by tag.
+	// Each event is routed to its tag's output FIFO in one pass, via a table indexed directly by tag. Consumers read their
+	// tag's output FIFO like any other FIFO, so mergers and condition processors can take it as input without filtering.
+	// Events with tags that don't have an output go to the demultiplexer's own output.
+	// NOTE - Tag outputs only have their watermarks advanced by their own events and by advanceToTime().
+	// For lazy pulling, set the pull source on the demultiplexer; reading a tag output lazily pulls through it.
+	class COMMON_LIB TagDemux : public LogicFIFO
+	{
+	public:
+		// Constructor.
+		TagDemux();
+		// Default destructor is fine. This owns the tag outputs.
+
+		// Configuration. This should be done during setup, since it allocates.
+		// Adding a tag that already has an output returns the existing output. Out-of-range tags return NULL.
+		// NOTE - Don't clear tag outputs while anything is still reading from them.
+		LogicFIFO* addTagOutput(int outputTag);
+		LogicFIFO* getTagOutput(int outputTag);
+		void clearTagOutputs();
+
+		// Setup. This also clears the tag outputs.
+		void clearBuffer() override;
+
+		// Input processing.
+		void handleInput(int64 inputTime, bool inputLevel, int inputTag = 0) override;
+		void handleInputBatch(const LogicEvent *inputEvents, int eventCount) override;
+		void advanceToTime(int64 newTime) override;
+		// Unlike the base class version, this forwards every event, since events with the same time may have different tags.
+		void pullFromFIFOUntil(LogicFIFO *source, int64 newTime) override;
+
+		// Statistics.
+		int64 getUnroutedCount();
+
+		// Checkpointing. Tag outputs have to have been set up the same way before restoring.
+		void writeState(MemoryOutputStream &dest) override;
+		bool readState(MemoryInputStream &source) override;
+
+	protected:
+		OwnedArray<TagDemuxOutput> tagOutputs;
+		Array<int> tagOutputIDs;
+		// Direct lookup by tag. Entries are NULL for tags without an output.
+		Array<LogicFIFO*> tagTable;
+
+		int64 unroutedCount;
 	};
 }
 
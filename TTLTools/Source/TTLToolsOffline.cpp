@@ -0,0 +1,292 @@
+#include "TTLTools.h"
+#define LOGICDEBUGPREFIX "[TTLToolsOffline] "
+#include "TTLToolsDebug.h"
+
+#include <thread>
+
+using namespace TTLTools;
+
+// Private constants.
+
+// This timestamp could happen, but we need _something_ as the default.
+#define LOGIC_TIMESTAMP_BOGUS (-1)
+
+// Maximum number of dead time intervals to advance by at once, so that phantom re-triggers can't overflow the output buffer.
+#define OFFLINE_MAX_STEP_DEADTIMES 2048
+
+
+//
+// Offline condition processing of a long, fully-recorded event stream.
+
+
+// Constructor.
+OfflineConditionRunner::OfflineConditionRunner()
+{
+    config.clear();
+
+    threadCount = 0;
+    minChunkEvents = TTLTOOLSOFFLINE_MIN_CHUNK_EVENTS;
+
+    initialTime = LOGIC_TIMESTAMP_BOGUS;
+    initialLevel = false;
+
+    lastChunkCount = 0;
+    lastRerunCount = 0;
+}
+
+
+// Configuration.
+
+void OfflineConditionRunner::setConfig(ConditionConfig &newConfig)
+{
+    config = newConfig;
+}
+
+
+ConditionConfig OfflineConditionRunner::getConfig()
+{
+    return config;
+}
+
+
+void OfflineConditionRunner::setThreadCount(int newCount)
+{
+    threadCount = (newCount < 0) ? 0 : newCount;
+}
+
+
+void OfflineConditionRunner::setMinChunkEvents(int newCount)
+{
+    minChunkEvents = (newCount < 1) ? 1 : newCount;
+}
+
+
+void OfflineConditionRunner::setInitialInput(int64 newTime, bool newLevel)
+{
+    initialTime = newTime;
+    initialLevel = newLevel;
+}
+
+
+// Statistics.
+
+int OfflineConditionRunner::getChunkCount()
+{
+    return lastChunkCount;
+}
+
+
+int OfflineConditionRunner::getRerunCount()
+{
+    return lastRerunCount;
+}
+
+
+// Processing.
+
+void OfflineConditionRunner::processEvents(const Array<LogicEvent> &inputEvents, int64 endTime, Array<LogicEvent> &outputEvents)
+{
+    int eventCount = inputEvents.size();
+
+    // Figure out how many chunks to use.
+    int chunkCount = threadCount;
+    if (chunkCount < 1)
+        chunkCount = SystemStats::getNumCpus();
+    if (chunkCount > (eventCount / minChunkEvents))
+        chunkCount = eventCount / minChunkEvents;
+    // Delay jitter makes every chunk depend on the number of earlier triggers.
+    if (config.delayMaxSamps != config.delayMinSamps)
+        chunkCount = 1;
+    if (chunkCount < 1)
+        chunkCount = 1;
+
+    lastChunkCount = chunkCount;
+    lastRerunCount = 0;
+
+    // Chunk boundaries are at event indices. Chunk N covers [chunkStarts[N], chunkStarts[N+1]).
+    Array<int> chunkStarts;
+    for (int chunkIdx = 0; chunkIdx <= chunkCount; chunkIdx++)
+        chunkStarts.add( (int) (((int64) eventCount * chunkIdx) / chunkCount) );
+
+    OwnedArray<ConditionProcessor> chunkProcs;
+    Array<MemoryBlock> startStates;
+    Array< Array<LogicEvent> > chunkOutputs;
+
+    for (int chunkIdx = 0; chunkIdx < chunkCount; chunkIdx++)
+    {
+        ConditionProcessor* thisProc = chunkProcs.add(new ConditionProcessor());
+        thisProc->setConfig(config);
+        startStates.add(MemoryBlock());
+        chunkOutputs.add(Array<LogicEvent>());
+    }
+
+    // Speculative processing. Chunk 0 starts from the real initial state; the others start after a warm-up window.
+    int64 warmupSamps = getWarmupSamps();
+
+    auto processChunk = [&](int chunkIdx)
+    {
+        ConditionProcessor &thisProc = *(chunkProcs[chunkIdx]);
+        int firstIdx = chunkStarts[chunkIdx];
+        int warmupIdx = 0;
+
+        if (chunkIdx > 0)
+        {
+            // Find the first event in the warm-up window.
+            int64 warmupStart = inputEvents.getReference(firstIdx).time - warmupSamps;
+            int loIdx = 0;
+            int hiIdx = firstIdx;
+            while (loIdx < hiIdx)
+            {
+                int midIdx = loIdx + ((hiIdx - loIdx) / 2);
+                if (inputEvents.getReference(midIdx).time < warmupStart)
+                    loIdx = midIdx + 1;
+                else
+                    hiIdx = midIdx;
+            }
+            warmupIdx = loIdx;
+
+            if (warmupIdx > (firstIdx - TTLTOOLSOFFLINE_WARMUP_EVENTS))
+                warmupIdx = firstIdx - TTLTOOLSOFFLINE_WARMUP_EVENTS;
+            if (warmupIdx < 0)
+                warmupIdx = 0;
+        }
+
+        // Starting from the very beginning is exact; otherwise, assume the input was steady before the warm-up window.
+        if (warmupIdx > 0)
+            thisProc.setPrevInput(inputEvents.getReference(warmupIdx - 1).time, inputEvents.getReference(warmupIdx - 1).level);
+        else
+            thisProc.setPrevInput(initialTime, initialLevel);
+
+        runEvents(thisProc, inputEvents, warmupIdx, firstIdx, NULL);
+
+        // Remember where we started, so that the stitching pass can check it.
+        MemoryOutputStream stateStream(startStates.getReference(chunkIdx), false);
+        thisProc.writeState(stateStream);
+
+        runEvents(thisProc, inputEvents, firstIdx, chunkStarts[chunkIdx + 1], &(chunkOutputs.getReference(chunkIdx)));
+    };
+
+    Array<std::thread*> workerThreads;
+    for (int chunkIdx = 1; chunkIdx < chunkCount; chunkIdx++)
+        workerThreads.add(new std::thread(processChunk, chunkIdx));
+
+    processChunk(0);
+
+    for (int tIdx = 0; tIdx < workerThreads.size(); tIdx++)
+    {
+        workerThreads[tIdx]->join();
+        delete workerThreads[tIdx];
+    }
+    workerThreads.clear();
+
+    // Stitching. Each chunk has to have started from the state the previous chunk ended in.
+    // The previous chunk's end state is always correct, since chunk 0 is, and mismatched chunks are re-run.
+    ConditionProcessor* scratchProc = new ConditionProcessor();
+    for (int chunkIdx = 1; chunkIdx < chunkCount; chunkIdx++)
+    {
+        ConditionProcessor &prevProc = *(chunkProcs[chunkIdx - 1]);
+        ConditionProcessor &thisProc = *(chunkProcs[chunkIdx]);
+
+        bool isMatch = false;
+        {
+            MemoryInputStream stateStream(startStates.getReference(chunkIdx), false);
+            if (scratchProc->readState(stateStream))
+                isMatch = scratchProc->matchesTriggerState(prevProc);
+        }
+
+        if (!isMatch)
+        {
+            MemoryBlock handoffState;
+            prevProc.saveState(handoffState);
+
+            if (!thisProc.loadState(handoffState))
+            {
+                L_WARN(".. WARNING - Couldn't hand off state to chunk " << chunkIdx << ".");
+            }
+
+            chunkOutputs.getReference(chunkIdx).clearQuick();
+            runEvents(thisProc, inputEvents, chunkStarts[chunkIdx], chunkStarts[chunkIdx + 1], &(chunkOutputs.getReference(chunkIdx)));
+            lastRerunCount++;
+        }
+    }
+    delete scratchProc;
+
+    // Flush everything up to the end time.
+    advanceProcessor(*(chunkProcs[chunkCount - 1]), endTime, &(chunkOutputs.getReference(chunkCount - 1)));
+
+    outputEvents.clearQuick();
+    for (int chunkIdx = 0; chunkIdx < chunkCount; chunkIdx++)
+    {
+        Array<LogicEvent> &thisOutput = chunkOutputs.getReference(chunkIdx);
+        for (int evIdx = 0; evIdx < thisOutput.size(); evIdx++)
+            outputEvents.add(thisOutput[evIdx]);
+    }
+}
+
+
+// Warm-up window. One span covers the last trigger's dead time, the input becoming stable, and pulses still in progress.
+int64 OfflineConditionRunner::getWarmupSamps()
+{
+    return TTLTOOLSOFFLINE_WARMUP_SPANS * (config.deadTimeSamps + config.deglitchSamps + config.delayMaxSamps + config.sustainSamps);
+}
+
+
+// Largest single time advance. Level triggers can re-trigger once per dead time with no input, so bound the output per step.
+int64 OfflineConditionRunner::getStepSamps()
+{
+    int64 deadTime = (config.deadTimeSamps < 1) ? 1 : config.deadTimeSamps;
+    return deadTime * OFFLINE_MAX_STEP_DEADTIMES;
+}
+
+
+// This feeds events [firstIdx, endIdx) to a processor. Output is appended to the output list if there is one, or discarded.
+void OfflineConditionRunner::runEvents(ConditionProcessor &proc, const Array<LogicEvent> &inputEvents, int firstIdx, int endIdx, Array<LogicEvent> *outputEvents)
+{
+    for (int evIdx = firstIdx; evIdx < endIdx; evIdx++)
+    {
+        const LogicEvent &thisEvent = inputEvents.getReference(evIdx);
+
+        // After a long gap, advance in steps to just before the event. This gives the same result as handling it directly.
+        if ((thisEvent.time - proc.getWatermark()) > getStepSamps())
+            advanceProcessor(proc, thisEvent.time - 1, outputEvents);
+
+        proc.handleInput(thisEvent.time, thisEvent.level, thisEvent.tag);
+        drainOutput(proc, outputEvents);
+    }
+}
+
+
+// This advances a processor to the specified time, in steps short enough that output can't overflow.
+void OfflineConditionRunner::advanceProcessor(ConditionProcessor &proc, int64 newTime, Array<LogicEvent> *outputEvents)
+{
+    int64 stepSamps = getStepSamps();
+    int64 thisTime = proc.getWatermark();
+
+    while ((newTime - thisTime) > stepSamps)
+    {
+        thisTime += stepSamps;
+        proc.advanceToTime(thisTime);
+        drainOutput(proc, outputEvents);
+    }
+
+    if (newTime > thisTime)
+    {
+        proc.advanceToTime(newTime);
+        drainOutput(proc, outputEvents);
+    }
+}
+
+
+// This moves all queued output to the output list, or discards it if there isn't one.
+void OfflineConditionRunner::drainOutput(ConditionProcessor &proc, Array<LogicEvent> *outputEvents)
+{
+    while (proc.hasPendingOutput())
+    {
+        if (NULL != outputEvents)
+            outputEvents->add(LogicEvent(proc.getNextOutputTime(), proc.getNextOutputLevel(), proc.getNextOutputTag()));
+        proc.acknowledgeOutput();
+    }
+}
+
+
+// This is the end of the file.
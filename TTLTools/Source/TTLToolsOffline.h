@@ -0,0 +1,76 @@
+#ifndef TTLTOOLS_OFFLINE_H_DEFINED
+#define TTLTOOLS_OFFLINE_H_DEFINED
+
+// This is intended to be included via "TTLTools.h", rather than included manually.
+
+
+// Magic constant: default minimum number of input events per chunk for parallel offline processing.
+// Smaller chunks spend proportionally more time on warm-up.
+#define TTLTOOLSOFFLINE_MIN_CHUNK_EVENTS 16384
+
+// Magic constants: warm-up length, as a multiple of (dead time + deglitch + delay + sustain), and in input events.
+// Re-trigger chains only line up after an idle gap, so warming up for a single span usually isn't enough.
+// The warm-up window is whichever of these is longer.
+#define TTLTOOLSOFFLINE_WARMUP_SPANS 16
+#define TTLTOOLSOFFLINE_WARMUP_EVENTS 256
+
+
+// Class declarations.
+namespace TTLTools
+{
+	// Offline condition processing of a long, fully-recorded event stream.
+	// The stream is split into time chunks that are processed on separate threads. Each chunk starts from the state
+	// reached by re-simulating a warm-up window before it, sized from the dead time, deglitch time, and pulse length.
+	// Afterwards, each chunk's starting state is checked against the state handed off by the previous chunk, and any
+	// chunk that started from a different state is re-run from the handed-off state. Output is identical to serial processing.
+	// NOTE - With random delay jitter, each chunk depends on the number of earlier triggers, so that runs serially.
+	class COMMON_LIB OfflineConditionRunner
+	{
+	public:
+		// Constructor.
+		OfflineConditionRunner();
+		// Default destructor is fine.
+
+		// Configuration.
+		void setConfig(ConditionConfig &newConfig);
+		ConditionConfig getConfig();
+
+		// Zero threads means one per CPU.
+		void setThreadCount(int newCount);
+		void setMinChunkEvents(int newCount);
+
+		// Initial input state. The default matches a freshly constructed ConditionProcessor.
+		void setInitialInput(int64 newTime, bool newLevel);
+
+		// This processes an entire recording. Input must be in time order.
+		// Output contains everything produced up to endTime.
+		void processEvents(const Array<LogicEvent> &inputEvents, int64 endTime, Array<LogicEvent> &outputEvents);
+
+		// Statistics from the last call to processEvents().
+		int getChunkCount();
+		int getRerunCount();
+
+	protected:
+		ConditionConfig config;
+		int threadCount;
+		int minChunkEvents;
+
+		int64 initialTime;
+		bool initialLevel;
+
+		int lastChunkCount;
+		int lastRerunCount;
+
+		int64 getWarmupSamps();
+		int64 getStepSamps();
+		// This feeds events [firstIdx, endIdx) to a processor. Output is appended to the output list if there is one, or discarded.
+		void runEvents(ConditionProcessor &proc, const Array<LogicEvent> &inputEvents, int firstIdx, int endIdx, Array<LogicEvent> *outputEvents);
+		void advanceProcessor(ConditionProcessor &proc, int64 newTime, Array<LogicEvent> *outputEvents);
+		void drainOutput(ConditionProcessor &proc, Array<LogicEvent> *outputEvents);
+	};
+}
+
+#endif
+
+
+// This is the end of the file.
@@ -0,0 +1,295 @@
+#include "TTLTools.h"
+#define LOGICDEBUGPREFIX "[TTLToolsPSTH] "
+#include "TTLToolsDebug.h"
+
+using namespace TTLTools;
+
+// Private constants.
+
+// This timestamp could happen, but we need _something_ as the default.
+#define LOGIC_TIMESTAMP_BOGUS (-1)
+
+#define PSTH_HISTORY_MASK (TTLTOOLSPSTH_HISTORY_SIZE - 1)
+
+
+//
+// Streaming peri-event time histogram accumulator.
+
+
+// Constructor.
+PSTHAccumulator::PSTHAccumulator()
+{
+    refInput = NULL;
+    targetInput = NULL;
+    refLevel = true;
+    targetLevel = true;
+
+    targetCount = 1;
+    binCount = 20;
+    preSamps = 3000;
+    binSamps = 300;
+    windowSamps = binCount * binSamps;
+
+    resetRequested.set(0);
+
+    resetCounts();
+}
+
+
+// Configuration.
+
+void PSTHAccumulator::setBins(int64 newPreSamps, int64 newBinSamps, int newBinCount)
+{
+    binCount = newBinCount;
+    if (binCount < 1)
+        binCount = 1;
+    if (binCount > TTLTOOLSPSTH_MAX_BINS)
+        binCount = TTLTOOLSPSTH_MAX_BINS;
+
+    binSamps = (newBinSamps < 1) ? 1 : newBinSamps;
+    windowSamps = binCount * binSamps;
+
+    // The window has to include the reference event's own time (or touch it from either side).
+    preSamps = newPreSamps;
+    if (preSamps < 0)
+        preSamps = 0;
+    if (preSamps > windowSamps)
+        preSamps = windowSamps;
+
+    resetCounts();
+}
+
+
+void PSTHAccumulator::setTargetCount(int newCount)
+{
+    targetCount = newCount;
+    if (targetCount < 1)
+        targetCount = 1;
+    if (targetCount > TTLTOOLSPSTH_MAX_TARGETS)
+        targetCount = TTLTOOLSPSTH_MAX_TARGETS;
+
+    resetCounts();
+}
+
+
+void PSTHAccumulator::setEventLevels(bool newRefLevel, bool newTargetLevel)
+{
+    refLevel = newRefLevel;
+    targetLevel = newTargetLevel;
+
+    resetCounts();
+}
+
+
+void PSTHAccumulator::setInputs(LogicFIFO* newRefInput, LogicFIFO* newTargetInput)
+{
+    refInput = newRefInput;
+    targetInput = newTargetInput;
+
+    resetCounts();
+}
+
+
+// This clears the counts and the event window.
+void PSTHAccumulator::resetCounts()
+{
+    accumCounts.targetCount = targetCount;
+    accumCounts.binCount = binCount;
+    accumCounts.preSamps = preSamps;
+    accumCounts.binSamps = binSamps;
+
+    accumCounts.referenceCount = 0;
+    accumCounts.processedTime = LOGIC_TIMESTAMP_BOGUS;
+
+    for (int countIdx = 0; countIdx < (targetCount * binCount); countIdx++)
+        accumCounts.binCounts[countIdx] = 0;
+
+    clearHistory();
+    overflowCount = 0;
+}
+
+
+// This can be called from any thread.
+void PSTHAccumulator::requestReset()
+{
+    resetRequested.set(1);
+}
+
+
+// Processing. Both inputs must be complete up to newTime.
+void PSTHAccumulator::processUntil(int64 newTime)
+{
+    if (0 != resetRequested.exchange(0))
+        resetCounts();
+
+    while (true)
+    {
+        bool haveRef = (NULL != refInput) && refInput->hasPendingOutput() && (refInput->getNextOutputTime() <= newTime);
+        bool haveTarget = (NULL != targetInput) && targetInput->hasPendingOutput() && (targetInput->getNextOutputTime() <= newTime);
+
+        if (!(haveRef || haveTarget))
+            break;
+
+        // References go first when timestamps are equal, so that every pair is counted exactly once.
+        if ( haveRef && ( (!haveTarget) || (refInput->getNextOutputTime() <= targetInput->getNextOutputTime()) ) )
+        {
+            if (refInput->getNextOutputLevel() == refLevel)
+                handleReference(refInput->getNextOutputTime());
+            refInput->acknowledgeOutput();
+        }
+        else
+        {
+            int thisTag = targetInput->getNextOutputTag();
+            if ( (targetInput->getNextOutputLevel() == targetLevel) && (thisTag >= 0) && (thisTag < targetCount) )
+                handleTarget(targetInput->getNextOutputTime(), thisTag);
+            targetInput->acknowledgeOutput();
+        }
+    }
+
+    if (newTime > accumCounts.processedTime)
+        accumCounts.processedTime = newTime;
+
+    publishSnapshot();
+}
+
+
+// This copies the in-use part of the histogram to the triple buffer's write slot and publishes it.
+void PSTHAccumulator::publishSnapshot()
+{
+    PSTHSnapshot &destSnapshot = snapshotBuffer.getWriteSlot();
+
+    destSnapshot.targetCount = accumCounts.targetCount;
+    destSnapshot.binCount = accumCounts.binCount;
+    destSnapshot.preSamps = accumCounts.preSamps;
+    destSnapshot.binSamps = accumCounts.binSamps;
+    destSnapshot.referenceCount = accumCounts.referenceCount;
+    destSnapshot.processedTime = accumCounts.processedTime;
+
+    for (int countIdx = 0; countIdx < (accumCounts.targetCount * accumCounts.binCount); countIdx++)
+        destSnapshot.binCounts[countIdx] = accumCounts.binCounts[countIdx];
+
+    snapshotBuffer.publish();
+}
+
+
+// Reader side.
+
+bool PSTHAccumulator::fetchSnapshot()
+{
+    return snapshotBuffer.fetchLatest();
+}
+
+
+const PSTHSnapshot &PSTHAccumulator::getSnapshot()
+{
+    return snapshotBuffer.getReadSlot();
+}
+
+
+// Statistics.
+
+int64 PSTHAccumulator::getReferenceCount()
+{
+    return accumCounts.referenceCount;
+}
+
+
+int64 PSTHAccumulator::getOverflowCount()
+{
+    return overflowCount;
+}
+
+
+// A reference event counts all remembered targets that precede it within the window, and is remembered for later targets.
+void PSTHAccumulator::handleReference(int64 refTime)
+{
+    accumCounts.referenceCount++;
+
+    // Targets before the window start can't be in any later reference's window either.
+    while ( (targetHeld > 0) && (targetHistoryTimes[targetFirst] < (refTime - preSamps)) )
+    {
+        targetFirst = (targetFirst + 1) & PSTH_HISTORY_MASK;
+        targetHeld--;
+    }
+
+    for (int hIdx = 0; hIdx < targetHeld; hIdx++)
+    {
+        int ringIdx = (targetFirst + hIdx) & PSTH_HISTORY_MASK;
+        int64 relTime = targetHistoryTimes[ringIdx] - refTime;
+
+        // Targets at or after the reference time were counted when they arrived.
+        if (relTime < 0)
+            accumCounts.binCounts[targetHistoryRows[ringIdx] * binCount + (int) ((relTime + preSamps) / binSamps)]++;
+    }
+
+    // Later targets only need this if the window extends past the reference time.
+    if (windowSamps > preSamps)
+    {
+        if (refHeld >= TTLTOOLSPSTH_HISTORY_SIZE)
+        {
+            refFirst = (refFirst + 1) & PSTH_HISTORY_MASK;
+            refHeld--;
+            overflowCount++;
+        }
+
+        refHistory[(refFirst + refHeld) & PSTH_HISTORY_MASK] = refTime;
+        refHeld++;
+    }
+}
+
+
+// A target event is counted against all remembered references within the window, and is remembered for later references.
+void PSTHAccumulator::handleTarget(int64 targetTime, int targetIdx)
+{
+    int64 postSamps = windowSamps - preSamps;
+
+    // References this far back can't have any later target in their window either.
+    while ( (refHeld > 0) && (refHistory[refFirst] <= (targetTime - postSamps)) )
+    {
+        refFirst = (refFirst + 1) & PSTH_HISTORY_MASK;
+        refHeld--;
+    }
+
+    int64* rowCounts = &(accumCounts.binCounts[targetIdx * binCount]);
+    for (int hIdx = 0; hIdx < refHeld; hIdx++)
+    {
+        int64 relTime = targetTime - refHistory[(refFirst + hIdx) & PSTH_HISTORY_MASK];
+        rowCounts[(int) ((relTime + preSamps) / binSamps)]++;
+    }
+
+    // Later references only need this if the window extends before the reference time.
+    if (preSamps > 0)
+    {
+        // Later references are no earlier than this target, so older targets can't be in their windows.
+        // Dropping these first means that only targets that were still needed count as overflow.
+        while ( (targetHeld > 0) && (targetHistoryTimes[targetFirst] < (targetTime - preSamps)) )
+        {
+            targetFirst = (targetFirst + 1) & PSTH_HISTORY_MASK;
+            targetHeld--;
+        }
+
+        if (targetHeld >= TTLTOOLSPSTH_HISTORY_SIZE)
+        {
+            targetFirst = (targetFirst + 1) & PSTH_HISTORY_MASK;
+            targetHeld--;
+            overflowCount++;
+        }
+
+        int ringIdx = (targetFirst + targetHeld) & PSTH_HISTORY_MASK;
+        targetHistoryTimes[ringIdx] = targetTime;
+        targetHistoryRows[ringIdx] = targetIdx;
+        targetHeld++;
+    }
+}
+
+
+void PSTHAccumulator::clearHistory()
+{
+    refFirst = 0;
+    refHeld = 0;
+    targetFirst = 0;
+    targetHeld = 0;
+}
+
+
+// This is the end of the file.
@@ -0,0 +1,132 @@
+#ifndef TTLTOOLS_PSTH_H_DEFINED
+#define TTLTOOLS_PSTH_H_DEFINED
+
+// This is intended to be included via "TTLTools.h", rather than included manually.
+
+
+// Magic constants: histogram size limits. Histograms are statically allocated at the maximum size.
+#define TTLTOOLSPSTH_MAX_TARGETS 16
+#define TTLTOOLSPSTH_MAX_BINS 256
+
+// Magic constant: number of recent reference and target events remembered. This must be a power of 2.
+#define TTLTOOLSPSTH_HISTORY_SIZE 4096
+
+
+// Class declarations.
+namespace TTLTools
+{
+	// Peri-event time histogram counts, for display.
+	// Counts are stored contiguously, one row of bins per target (target N's bins start at N * binCount).
+	// Nothing in here is dynamically allocated, so copy-by-value is fine.
+	// NOTE - This should NOT use the "COMMON_LIB" macro; it's entirely inline.
+	class PSTHSnapshot
+	{
+	public:
+		int targetCount;
+		int binCount;
+		int64 preSamps;
+		int64 binSamps;
+
+		// Number of reference events seen, and the time up to which input was processed.
+		int64 referenceCount;
+		int64 processedTime;
+
+		int64 binCounts[TTLTOOLSPSTH_MAX_TARGETS * TTLTOOLSPSTH_MAX_BINS];
+
+		// Constructor. An empty snapshot has no bins; bin counts are only initialized when there are bins.
+		PSTHSnapshot()
+		{
+			targetCount = 0;
+			binCount = 0;
+			preSamps = 0;
+			binSamps = 1;
+			referenceCount = 0;
+			processedTime = -1;
+		}
+
+		// Bin N covers relative times [N * binSamps - preSamps, (N+1) * binSamps - preSamps).
+		int64 getCount(int targetIdx, int binIdx) const
+		{
+			if ( (targetIdx < 0) || (targetIdx >= targetCount) || (binIdx < 0) || (binIdx >= binCount) )
+				return 0;
+			return binCounts[targetIdx * binCount + binIdx];
+		}
+	};
+
+
+	// Streaming peri-event time histogram accumulator.
+	// This consumes a reference event stream and a tagged target event stream (such as MuxMerger output), and counts
+	// target events in fixed-width bins relative to each reference event. The event tag selects the target row.
+	// Each reference/target pair is counted once, when the later of the two arrives, using a sliding window of recent
+	// events; old events are dropped from the window in amortized O(1) time.
+	// Counts are published through a triple buffer, so a display thread can read snapshots without locking.
+	// NOTE - This is large (several copies of the histogram). Allocate it on the heap.
+	class COMMON_LIB PSTHAccumulator
+	{
+	public:
+		// Constructor.
+		PSTHAccumulator();
+		// Default destructor is fine.
+
+		// Configuration. These reset the counts, and should be called from the processing thread.
+		// The histogram window is [-preSamps, binCount * binSamps - preSamps) relative to each reference event.
+		void setBins(int64 newPreSamps, int64 newBinSamps, int newBinCount);
+		void setTargetCount(int newCount);
+		// Only events with these levels count (rising edges by default).
+		void setEventLevels(bool newRefLevel, bool newTargetLevel);
+		// Input events are acknowledged as they're processed, so this object should be the only consumer of these FIFOs.
+		void setInputs(LogicFIFO* newRefInput, LogicFIFO* newTargetInput);
+
+		// This clears the counts and the event window. It should be called from the processing thread.
+		void resetCounts();
+		// This can be called from any thread. The reset happens at the start of the next processUntil() call.
+		void requestReset();
+
+		// Processing. Both inputs must be complete up to newTime. This publishes a new snapshot when done.
+		void processUntil(int64 newTime);
+		void publishSnapshot();
+
+		// Reader side. fetchSnapshot() returns true if a new snapshot was published since the last fetch.
+		// NOTE - Only one thread may read snapshots.
+		bool fetchSnapshot();
+		const PSTHSnapshot &getSnapshot();
+
+		// Statistics. The overflow count is the number of events pushed out of the window before they expired.
+		int64 getReferenceCount();
+		int64 getOverflowCount();
+
+	protected:
+		LogicFIFO* refInput;
+		LogicFIFO* targetInput;
+		bool refLevel;
+		bool targetLevel;
+
+		int targetCount;
+		int binCount;
+		int64 preSamps;
+		int64 binSamps;
+		int64 windowSamps;
+
+		PSTHSnapshot accumCounts;
+		TripleBuffer<PSTHSnapshot> snapshotBuffer;
+		Atomic<int> resetRequested;
+
+		// Recent reference times (for later targets) and recent target times (for later references), as rings.
+		int64 refHistory[TTLTOOLSPSTH_HISTORY_SIZE];
+		int refFirst, refHeld;
+		int64 targetHistoryTimes[TTLTOOLSPSTH_HISTORY_SIZE];
+		int targetHistoryRows[TTLTOOLSPSTH_HISTORY_SIZE];
+		int targetFirst, targetHeld;
+
+		int64 overflowCount;
+
+		void handleReference(int64 refTime);
+		void handleTarget(int64 targetTime, int targetIdx);
+		void clearHistory();
+	};
+}
+
+#endif
+
+
+// This is the end of the file.
@@ -0,0 +1,250 @@
+#include "TTLTools.h"
+#define LOGICDEBUGPREFIX "[TTLToolsProf] "
+#include "TTLToolsDebug.h"
+
+#include <atomic>
+
+#if defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+using namespace TTLTools;
+
+
+//
+// Per-thread profiling counters.
+
+// Each thread only writes its own counters, so updates are plain relaxed loads and stores rather than locked increments.
+// Other threads may read them at any time.
+// This is private to this file, so it's in an anonymous namespace to keep it from clashing with anything else.
+namespace
+{
+class ProfileThreadCounters
+{
+public:
+    std::atomic<int64> cycles[LogicProfiler::profileSlotCount];
+    std::atomic<int64> calls[LogicProfiler::profileSlotCount];
+    std::atomic<int64> events[LogicProfiler::profileSlotCount];
+
+    // Thread counters register themselves. The retired totals don't.
+    ProfileThreadCounters(bool wantRegister = true);
+    ~ProfileThreadCounters();
+
+    bool isRegistered;
+
+    void clear();
+    void addTo(int slot, std::atomic<int64> *counter, int64 amount);
+};
+}
+
+
+// The registry of live threads' counters, plus totals from threads that have exited.
+// These are allocated once and never freed, so that threads exiting during shutdown can still unregister.
+static CriticalSection &getProfileLock()
+{
+    static CriticalSection* theLock = new CriticalSection();
+    return *theLock;
+}
+
+
+static Array<ProfileThreadCounters*> &getProfileThreadList()
+{
+    static Array<ProfileThreadCounters*>* theList = new Array<ProfileThreadCounters*>();
+    return *theList;
+}
+
+
+static ProfileThreadCounters &getRetiredCounters()
+{
+    static ProfileThreadCounters* theCounters = new ProfileThreadCounters(false);
+    return *theCounters;
+}
+
+
+// Constructor. This registers the counters.
+ProfileThreadCounters::ProfileThreadCounters(bool wantRegister)
+{
+    clear();
+
+    isRegistered = wantRegister;
+    if (isRegistered)
+    {
+        const ScopedLock lock(getProfileLock());
+        getProfileThreadList().add(this);
+    }
+}
+
+
+// Destructor. This folds our counts into the retired totals and unregisters.
+ProfileThreadCounters::~ProfileThreadCounters()
+{
+    if (!isRegistered)
+        return;
+
+    ProfileThreadCounters &retired = getRetiredCounters();
+
+    const ScopedLock lock(getProfileLock());
+
+    getProfileThreadList().removeFirstMatchingValue(this);
+
+    for (int slot = 0; slot < LogicProfiler::profileSlotCount; slot++)
+    {
+        retired.cycles[slot] += cycles[slot].load(std::memory_order_relaxed);
+        retired.calls[slot] += calls[slot].load(std::memory_order_relaxed);
+        retired.events[slot] += events[slot].load(std::memory_order_relaxed);
+    }
+}
+
+
+void ProfileThreadCounters::clear()
+{
+    for (int slot = 0; slot < LogicProfiler::profileSlotCount; slot++)
+    {
+        cycles[slot].store(0, std::memory_order_relaxed);
+        calls[slot].store(0, std::memory_order_relaxed);
+        events[slot].store(0, std::memory_order_relaxed);
+    }
+}
+
+
+// Only the owning thread calls this, so load-then-store doesn't lose updates.
+void ProfileThreadCounters::addTo(int slot, std::atomic<int64> *counter, int64 amount)
+{
+    if ( (slot >= 0) && (slot < LogicProfiler::profileSlotCount) )
+        counter[slot].store(counter[slot].load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+
+// This thread's counters. These are created on first use.
+static ProfileThreadCounters &getThreadCounters()
+{
+    static thread_local ProfileThreadCounters theCounters;
+    return theCounters;
+}
+
+
+
+//
+// Library-specific profiler.
+
+
+bool LogicProfiler::isEnabled()
+{
+#if LOGICWANTPROFILE
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+void LogicProfiler::resetCounters()
+{
+    const ScopedLock lock(getProfileLock());
+
+    Array<ProfileThreadCounters*> &threadList = getProfileThreadList();
+    for (int tIdx = 0; tIdx < threadList.size(); tIdx++)
+        threadList[tIdx]->clear();
+
+    getRetiredCounters().clear();
+}
+
+
+void LogicProfiler::getTotals(int slot, int64 &cycles, int64 &calls, int64 &events)
+{
+    cycles = 0;
+    calls = 0;
+    events = 0;
+
+    if ( (slot < 0) || (slot >= profileSlotCount) )
+        return;
+
+    const ScopedLock lock(getProfileLock());
+
+    ProfileThreadCounters &retired = getRetiredCounters();
+    cycles = retired.cycles[slot].load(std::memory_order_relaxed);
+    calls = retired.calls[slot].load(std::memory_order_relaxed);
+    events = retired.events[slot].load(std::memory_order_relaxed);
+
+    Array<ProfileThreadCounters*> &threadList = getProfileThreadList();
+    for (int tIdx = 0; tIdx < threadList.size(); tIdx++)
+    {
+        cycles += threadList[tIdx]->cycles[slot].load(std::memory_order_relaxed);
+        calls += threadList[tIdx]->calls[slot].load(std::memory_order_relaxed);
+        events += threadList[tIdx]->events[slot].load(std::memory_order_relaxed);
+    }
+}
+
+
+const char* LogicProfiler::getSlotName(int slot)
+{
+    switch (slot)
+    {
+    case profileMergerProcess:
+        return "processPendingInputUntil";
+    case profileConditionPhantom:
+        return "checkPhantomEventsUntil";
+    case profilePullFromFIFO:
+        return "pullFromFIFOUntil";
+    case profileEnqueueOutput:
+        return "enqueueOutput";
+    default:
+        return "(unknown)";
+    }
+}
+
+
+void LogicProfiler::printProfile()
+{
+    if (!isEnabled())
+    {
+        std::cout << LOGICDEBUGPREFIX << "Profiling is not compiled in (LOGICWANTPROFILE)." << std::endl << std::flush;
+        return;
+    }
+
+    std::cout << LOGICDEBUGPREFIX << "function, calls, events, cycles, cycles/call, cycles/event" << std::endl;
+
+    for (int slot = 0; slot < profileSlotCount; slot++)
+    {
+        int64 cycles, calls, events;
+        getTotals(slot, cycles, calls, events);
+
+        std::cout << LOGICDEBUGPREFIX << getSlotName(slot) << ", " << calls << ", " << events << ", " << cycles
+            << ", " << ( (calls > 0) ? (cycles / calls) : 0 )
+            << ", " << ( (events > 0) ? (cycles / events) : 0 ) << std::endl;
+    }
+
+    std::cout << std::flush;
+}
+
+
+int64 LogicProfiler::readCycleCounter()
+{
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+    return (int64) __rdtsc();
+#else
+    return Time::getHighResolutionTicks();
+#endif
+}
+
+
+void LogicProfiler::recordCall(int slot, int64 cycles)
+{
+    ProfileThreadCounters &counters = getThreadCounters();
+
+    counters.addTo(slot, counters.cycles, cycles);
+    counters.addTo(slot, counters.calls, 1);
+}
+
+
+void LogicProfiler::recordEvents(int slot, int64 count)
+{
+    ProfileThreadCounters &counters = getThreadCounters();
+
+    counters.addTo(slot, counters.events, count);
+}
+
+
+// This is the end of the file.
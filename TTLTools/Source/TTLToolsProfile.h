@@ -0,0 +1,74 @@
+#ifndef TTLTOOLS_PROFILE_H_DEFINED
+#define TTLTOOLS_PROFILE_H_DEFINED
+
+// This is intended to be included via "TTLTools.h", rather than included manually.
+
+// Profiling is compiled in or out with LOGICWANTPROFILE in "TTLToolsDebug.h". When it's compiled out, the profiling
+// hooks in the library are empty and these functions report nothing.
+
+
+// Class declarations.
+namespace TTLTools
+{
+	// Library-specific profiler.
+	// Instrumented functions record cycle counts, call counts, and event counts into per-thread counters.
+	// Counters are summed across threads (including threads that have exited) when read.
+	// Times are inclusive: a function's time includes time spent in instrumented functions it calls.
+	class COMMON_LIB LogicProfiler
+	{
+	public:
+		enum ProfileSlot
+		{
+			profileMergerProcess = 0,
+			profileConditionPhantom = 1,
+			profilePullFromFIFO = 2,
+			profileEnqueueOutput = 3,
+			profileSlotCount = 4
+		};
+
+		// This returns true if profiling was compiled in.
+		static bool isEnabled();
+
+		// Counter access. Reading while other threads are recording is fine, but totals may be slightly stale.
+		// NOTE - Only reset counters while nothing is being processed, or some counts may survive the reset.
+		static void resetCounters();
+		static void getTotals(int slot, int64 &cycles, int64 &calls, int64 &events);
+		static const char* getSlotName(int slot);
+
+		// This prints a per-function summary to the console.
+		static void printProfile();
+
+		// Recording. Instrumented code calls these via the L_PROFILE macros in "TTLToolsDebug.h".
+		// Cycles are TSC ticks where available, and high-resolution timer ticks otherwise.
+		static int64 readCycleCounter();
+		static void recordCall(int slot, int64 cycles);
+		static void recordEvents(int slot, int64 count);
+	};
+
+
+	// Scoped timer. This records one call and its duration when it goes out of scope.
+	// NOTE - This should NOT use the "COMMON_LIB" macro; it's entirely inline.
+	class ProfileScope
+	{
+	public:
+		ProfileScope(int newSlot)
+		{
+			slot = newSlot;
+			startCycles = LogicProfiler::readCycleCounter();
+		}
+
+		~ProfileScope()
+		{
+			LogicProfiler::recordCall(slot, LogicProfiler::readCycleCounter() - startCycles);
+		}
+
+	protected:
+		int slot;
+		int64 startCycles;
+	};
+}
+
+#endif
+
+
+// This is the end of the file.
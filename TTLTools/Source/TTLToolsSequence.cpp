@@ -0,0 +1,394 @@
+#include "TTLTools.h"
+#define LOGICDEBUGPREFIX "[TTLToolsSequence] "
+#define LOGICDEBUGIDVARIABLE debugID
+#include "TTLToolsDebug.h"
+
+using namespace TTLTools;
+
+// Private constants.
+
+// This timestamp could happen, but we need _something_ as the default.
+#define LOGIC_TIMESTAMP_BOGUS (-1)
+
+// Checkpoint section identifier.
+#define SEQ_STATE_MAGIC 0x51455354
+
+// State table actions.
+// Restarting is a failure followed by matching the first step with the same event.
+#define SEQ_ACTION_IGNORE 0
+#define SEQ_ACTION_ADVANCE 1
+#define SEQ_ACTION_FAIL 2
+#define SEQ_ACTION_RESTART 3
+
+#define SEQ_SYMBOL_COUNT (TTLTOOLSSEQ_MAX_TAGS * 2)
+
+
+//
+// One step of a sequence pattern.
+
+
+// Constructor.
+SequenceStep::SequenceStep()
+{
+    // Initialize to safe defaults.
+    clear();
+}
+
+
+// This sets a known-sane configuration state.
+void SequenceStep::clear()
+{
+    type = SequenceStep::stepEvent;
+    tag = 0;
+    level = true;
+
+    minDelaySamps = 0;
+    maxDelaySamps = 1500;
+    durationSamps = 1500;
+}
+
+
+// This forces configuration parameters to be valid and self-consistent.
+void SequenceStep::forceSanity()
+{
+    switch (type)
+    {
+    case SequenceStep::stepAbsence: break;
+    default:
+        type = SequenceStep::stepEvent;
+        break;
+    }
+
+    if (tag < 0)
+        tag = 0;
+    if (tag >= TTLTOOLSSEQ_MAX_TAGS)
+        tag = TTLTOOLSSEQ_MAX_TAGS - 1;
+
+    if (minDelaySamps < 0)
+        minDelaySamps = 0;
+    if (maxDelaySamps < minDelaySamps)
+        maxDelaySamps = minDelaySamps;
+
+    if (durationSamps < 0)
+        durationSamps = 0;
+}
+
+
+
+//
+// Multi-step sequence detector.
+
+
+// Constructor.
+SequenceDetector::SequenceDetector()
+{
+    stepCount = 0;
+    sustainSamps = 1000;
+    detectionCount = 0;
+
+    rebuildTable();
+    clearMatchState();
+}
+
+
+// Configuration.
+
+void SequenceDetector::clearSteps()
+{
+    stepCount = 0;
+
+    rebuildTable();
+    clearMatchState();
+}
+
+
+int SequenceDetector::addStep(SequenceStep &newStep)
+{
+    if (stepCount >= TTLTOOLSSEQ_MAX_STEPS)
+        return -1;
+
+    SequenceStep thisStep = newStep;
+    thisStep.forceSanity();
+
+    // An absence has to be measured from something.
+    if ( (0 == stepCount) && (SequenceStep::stepAbsence == thisStep.type) )
+    {
+        L_WARN(".. WARNING - The first step of a sequence can't be an absence.");
+        return -1;
+    }
+
+    patternSteps[stepCount] = thisStep;
+    stepCount++;
+
+    rebuildTable();
+    clearMatchState();
+
+    return stepCount - 1;
+}
+
+
+int SequenceDetector::getStepCount()
+{
+    return stepCount;
+}
+
+
+void SequenceDetector::setOutputSustain(int64 newSustainSamps)
+{
+    sustainSamps = (newSustainSamps < 1) ? 1 : newSustainSamps;
+}
+
+
+// Setup.
+void SequenceDetector::clearBuffer()
+{
+    LogicFIFO::clearBuffer();
+    clearMatchState();
+}
+
+
+// Input processing.
+void SequenceDetector::handleInput(int64 inputTime, bool inputLevel, int inputTag)
+{
+    // Anything due before this event happened first.
+    runTimersUntil(inputTime - 1);
+
+    if ( (inputTag >= 0) && (inputTag < TTLTOOLSSEQ_MAX_TAGS) )
+        handleSymbol(inputTime, (inputTag * 2) + (inputLevel ? 1 : 0));
+
+    // Update the "last input seen" record.
+    setPrevInput(inputTime, inputLevel, inputTag);
+
+    // More input may arrive with this timestamp, but not before it.
+    advanceWatermark(inputTime - 1);
+}
+
+
+void SequenceDetector::handleInputBatch(const LogicEvent *inputEvents, int eventCount)
+{
+    for (int evIdx = 0; evIdx < eventCount; evIdx++)
+        SequenceDetector::handleInput(inputEvents[evIdx].time, inputEvents[evIdx].level, inputEvents[evIdx].tag);
+}
+
+
+// Input processing. Input is complete up to and including newTime, so deadlines up to then can be resolved.
+void SequenceDetector::advanceToTime(int64 newTime)
+{
+    runTimersUntil(newTime);
+    advanceWatermark(newTime);
+}
+
+
+void SequenceDetector::pullFromFIFOUntil(LogicFIFO *source, int64 newTime)
+{
+    pullAllFromFIFOUntil(source, newTime);
+}
+
+
+// Statistics.
+
+int64 SequenceDetector::getDetectionCount()
+{
+    return detectionCount;
+}
+
+
+int SequenceDetector::getMatchedStepCount()
+{
+    return matchState;
+}
+
+
+// Checkpointing.
+
+void SequenceDetector::writeState(MemoryOutputStream &dest)
+{
+    dest.writeInt(SEQ_STATE_MAGIC);
+
+    dest.writeInt(stepCount);
+    dest.writeInt(matchState);
+    dest.writeInt64(stepTime);
+    dest.writeInt64(stateDeadline);
+
+    dest.writeBool(pulseActive);
+    dest.writeInt64(pulseEndTime);
+
+    dest.writeInt64(detectionCount);
+
+    LogicFIFO::writeState(dest);
+}
+
+
+bool SequenceDetector::readState(MemoryInputStream &source)
+{
+    if (source.getNumBytesRemaining() < 45)
+        return false;
+    if (SEQ_STATE_MAGIC != source.readInt())
+        return false;
+
+    int savedStepCount = source.readInt();
+    int newMatchState = source.readInt();
+    int64 newStepTime = source.readInt64();
+    int64 newDeadline = source.readInt64();
+
+    bool newPulseActive = source.readBool();
+    int64 newPulseEnd = source.readInt64();
+
+    int64 newDetectionCount = source.readInt64();
+
+    // The pattern isn't saved, but it has to be the same shape.
+    if ( (savedStepCount != stepCount) || (newMatchState < 0) || ((newMatchState > 0) && (newMatchState >= stepCount)) )
+        return false;
+
+    if (!LogicFIFO::readState(source))
+        return false;
+
+    matchState = newMatchState;
+    stepTime = newStepTime;
+    stateDeadline = newDeadline;
+
+    pulseActive = newPulseActive;
+    pulseEndTime = newPulseEnd;
+
+    detectionCount = newDetectionCount;
+
+    return true;
+}
+
+
+// This compiles the pattern into the state table.
+void SequenceDetector::rebuildTable()
+{
+    for (int symIdx = 0; symIdx < SEQ_SYMBOL_COUNT; symIdx++)
+        symbolStartsSequence[symIdx] = (stepCount > 0)
+            && (symIdx == ((patternSteps[0].tag * 2) + (patternSteps[0].level ? 1 : 0)));
+
+    for (int stateIdx = 0; stateIdx < TTLTOOLSSEQ_MAX_STEPS; stateIdx++)
+        for (int symIdx = 0; symIdx < SEQ_SYMBOL_COUNT; symIdx++)
+        {
+            uint8 thisAction = SEQ_ACTION_IGNORE;
+
+            if (stateIdx < stepCount)
+            {
+                SequenceStep &thisStep = patternSteps[stateIdx];
+                bool isMatch = ( symIdx == ((thisStep.tag * 2) + (thisStep.level ? 1 : 0)) );
+
+                // An absence step is only broken by its own event. That event may also start a new match.
+                // Otherwise, a new start only replaces the partial match while nothing past the first step has matched.
+                if (isMatch && (SequenceStep::stepEvent == thisStep.type))
+                    thisAction = SEQ_ACTION_ADVANCE;
+                else if (isMatch)
+                    thisAction = symbolStartsSequence[symIdx] ? SEQ_ACTION_RESTART : SEQ_ACTION_FAIL;
+                else if ( symbolStartsSequence[symIdx] && (1 == stateIdx) && (SequenceStep::stepEvent == thisStep.type) )
+                    thisAction = SEQ_ACTION_RESTART;
+            }
+
+            transitionTable[stateIdx][symIdx] = thisAction;
+        }
+}
+
+
+// This abandons any partial match and ends any output pulse.
+// NOTE - An output pulse that's in progress doesn't get a falling edge, so this should only be done during setup or when the output is reset.
+void SequenceDetector::clearMatchState()
+{
+    matchState = 0;
+    stepTime = LOGIC_TIMESTAMP_BOGUS;
+    stateDeadline = LOGIC_TIMESTAMP_BOGUS;
+
+    pulseActive = false;
+    pulseEndTime = LOGIC_TIMESTAMP_BOGUS;
+}
+
+
+// This applies one input event to the state machine.
+void SequenceDetector::handleSymbol(int64 inputTime, int inputSymbol)
+{
+    uint8 thisAction = transitionTable[matchState][inputSymbol];
+
+    // Events that match the current step too early don't count for it. They can still restart the sequence while
+    // waiting for the second step, same as any other new start.
+    if ( (SEQ_ACTION_ADVANCE == thisAction) && (matchState > 0)
+        && (inputTime < (stepTime + patternSteps[matchState].minDelaySamps)) )
+        thisAction = ( symbolStartsSequence[inputSymbol] && (1 == matchState) ) ? SEQ_ACTION_RESTART : SEQ_ACTION_IGNORE;
+
+    switch (thisAction)
+    {
+    case SEQ_ACTION_ADVANCE:
+        advanceMatch(inputTime);
+        break;
+    case SEQ_ACTION_FAIL:
+        matchState = 0;
+        break;
+    case SEQ_ACTION_RESTART:
+        matchState = 0;
+        advanceMatch(inputTime);
+        break;
+    default:
+        break;
+    }
+}
+
+
+// This processes deadlines and pulse ends up to and including the specified time, in time order.
+void SequenceDetector::runTimersUntil(int64 newTime)
+{
+    while (true)
+    {
+        bool haveDeadline = (matchState > 0) && (stateDeadline <= newTime);
+        bool havePulseEnd = pulseActive && (pulseEndTime <= newTime);
+
+        if (!(haveDeadline || havePulseEnd))
+            break;
+
+        // A detection at the same time as a pulse end extends the pulse, so deadlines go first.
+        if ( haveDeadline && ( (!havePulseEnd) || (stateDeadline <= pulseEndTime) ) )
+            handleDeadline();
+        else
+        {
+            enqueueOutput(pulseEndTime, false, 0);
+            pulseActive = false;
+        }
+    }
+}
+
+
+// The current step's deadline passed with no event. This completes an absence step, and fails an event step.
+void SequenceDetector::handleDeadline()
+{
+    if (SequenceStep::stepAbsence == patternSteps[matchState].type)
+        advanceMatch(stateDeadline);
+    else
+        matchState = 0;
+}
+
+
+// This records that the current step matched at the specified time, and fires if that was the last step.
+void SequenceDetector::advanceMatch(int64 matchTime)
+{
+    matchState++;
+    stepTime = matchTime;
+
+    if (matchState >= stepCount)
+    {
+        matchState = 0;
+        detectionCount++;
+
+        if (!pulseActive)
+            enqueueOutput(matchTime, true, 0);
+
+        pulseActive = true;
+        pulseEndTime = matchTime + sustainSamps;
+    }
+    else
+    {
+        SequenceStep &nextStep = patternSteps[matchState];
+        if (SequenceStep::stepAbsence == nextStep.type)
+            stateDeadline = matchTime + nextStep.durationSamps;
+        else
+            stateDeadline = matchTime + nextStep.maxDelaySamps;
+    }
+}
+
+
+// This is the end of the file.
@@ -0,0 +1,125 @@
+#ifndef TTLTOOLS_SEQUENCE_H_DEFINED
+#define TTLTOOLS_SEQUENCE_H_DEFINED
+
+// This is intended to be included via "TTLTools.h", rather than included manually.
+
+
+// Magic constants: pattern size limits. The state table is statically allocated at the maximum size.
+#define TTLTOOLSSEQ_MAX_STEPS 16
+#define TTLTOOLSSEQ_MAX_TAGS 32
+
+
+// Class declarations.
+namespace TTLTools
+{
+	// One step of a sequence pattern.
+	// Nothing in here is dynamically allocated, so copy-by-value is fine.
+	class COMMON_LIB SequenceStep
+	{
+	public:
+		enum StepType
+		{
+			// An event with the given tag and level, within [minDelaySamps, maxDelaySamps] after the previous step.
+			// For the first step, the delays are ignored.
+			stepEvent = 0,
+			// No event with the given tag and level for durationSamps after the previous step. This can't be the first step.
+			stepAbsence = 1
+		};
+
+		// Configuration parameters. External editing is fine.
+		StepType type;
+		int tag;
+		bool level;
+		int64 minDelaySamps;
+		int64 maxDelaySamps;
+		int64 durationSamps;
+
+		// Constructor.
+		SequenceStep();
+		// Default destructor is fine.
+
+		// This sets a known-sane configuration state.
+		void clear();
+		// This forces configuration parameters to be valid and self-consistent.
+		void forceSanity();
+	};
+
+
+	// Multi-step sequence detector, for tagged input (such as MuxMerger output).
+	// The pattern is a list of ordered steps, compiled to a state table indexed by (steps matched, event tag and level).
+	// There's one partial match at a time. A step's deadline (the end of its time window, or the end of an absence
+	// interval) is checked before each later event and when time advances.
+	// While waiting for the second step (if it's an event), a new match for the first step restarts the sequence, so the
+	// most recent start wins. After that, the partial match is kept: first-step events are ignored, and can't start a new
+	// match until the current one completes or fails. An absence step is only broken by its own event; if that event
+	// also matches the first step, it starts a new match.
+	// When the last step matches, an output pulse starts at that time. Detections during a pulse extend it.
+	// Each input event is one table lookup, plus any deadlines that expired before it.
+	class COMMON_LIB SequenceDetector : public LogicFIFO
+	{
+	public:
+		// Constructor.
+		SequenceDetector();
+		// Default destructor is fine.
+
+		// Configuration. Changing the pattern rebuilds the state table and restarts matching.
+		void clearSteps();
+		// This returns the step index, or -1 if there are too many steps or the step isn't valid here.
+		int addStep(SequenceStep &newStep);
+		int getStepCount();
+		void setOutputSustain(int64 newSustainSamps);
+
+		// Setup.
+		void clearBuffer() override;
+
+		// Input processing.
+		void handleInput(int64 inputTime, bool inputLevel, int inputTag = 0) override;
+		void handleInputBatch(const LogicEvent *inputEvents, int eventCount) override;
+		void advanceToTime(int64 newTime) override;
+		// Unlike the base class version, this forwards every event, since events with the same time may have different tags.
+		void pullFromFIFOUntil(LogicFIFO *source, int64 newTime) override;
+
+		// Statistics.
+		int64 getDetectionCount();
+		// Number of steps matched so far in the current partial match.
+		int getMatchedStepCount();
+
+		// Checkpointing. The pattern has to have been set up the same way before restoring.
+		void writeState(MemoryOutputStream &dest) override;
+		bool readState(MemoryInputStream &source) override;
+
+	protected:
+		SequenceStep patternSteps[TTLTOOLSSEQ_MAX_STEPS];
+		int stepCount;
+		int64 sustainSamps;
+
+		// Compiled pattern. Rows are states (number of steps matched), columns are event symbols (tag * 2 + level).
+		uint8 transitionTable[TTLTOOLSSEQ_MAX_STEPS][TTLTOOLSSEQ_MAX_TAGS * 2];
+		// Whether each symbol matches the first step, for events that arrive too early for the current step.
+		bool symbolStartsSequence[TTLTOOLSSEQ_MAX_TAGS * 2];
+
+		// Matching state. stepTime is when the previous step was matched; stateDeadline is the current step's deadline.
+		int matchState;
+		int64 stepTime;
+		int64 stateDeadline;
+
+		// Output pulse state.
+		bool pulseActive;
+		int64 pulseEndTime;
+
+		int64 detectionCount;
+
+		void rebuildTable();
+		void clearMatchState();
+		void handleSymbol(int64 inputTime, int inputSymbol);
+		// This processes deadlines and pulse ends up to and including the specified time, in time order.
+		void runTimersUntil(int64 newTime);
+		void handleDeadline();
+		void advanceMatch(int64 matchTime);
+	};
+}
+
+#endif
+
+
+// This is the end of the file.
@@ -0,0 +1,485 @@
+#include "TTLTools.h"
+#define LOGICDEBUGPREFIX "[TTLToolsShm] "
+#include "TTLToolsDebug.h"
+
+#include <atomic>
+#include <new>
+
+#if TTLTOOLSSHM_HAVE_POSIX
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace TTLTools;
+
+// Private constants.
+
+#define SHM_HEADER_BYTES 256
+#define SHM_EVENT_BYTES 16
+
+
+//
+// Shared memory segment header.
+
+// This matches the layout documented in "TTLToolsSharedMem.h". Counters that are written by different processes
+// are on separate cache lines.
+class SharedMemoryHeader
+{
+public:
+    std::atomic<uint32> magic;
+    uint32 version;
+    uint32 headerBytes;
+    uint32 eventBytes;
+    uint64 capacity;
+    char padIdent[64 - 24];
+
+    std::atomic<uint64> writeCount;
+    char padWrite[64 - 8];
+
+    std::atomic<uint64> readCount;
+    char padRead[64 - 8];
+
+    std::atomic<int64> watermark;
+    std::atomic<uint64> droppedCount;
+    char padState[64 - 16];
+};
+
+static_assert(sizeof(SharedMemoryHeader) == SHM_HEADER_BYTES, "Shared memory header doesn't match the documented layout.");
+static_assert(sizeof(SharedMemoryEvent) == SHM_EVENT_BYTES, "Shared memory event doesn't match the documented layout.");
+// Another process has to see the same counters, so they can't be implemented with a lock.
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "Shared memory counters need lock-free 64-bit atomics.");
+
+
+static SharedMemoryHeader* getHeader(void* segmentBase)
+{
+    return (SharedMemoryHeader*) segmentBase;
+}
+
+
+
+//
+// FIFO whose output goes to a named shared memory segment.
+
+
+// Constructor.
+SharedMemoryFIFO::SharedMemoryFIFO()
+{
+    segmentFD = -1;
+    segmentBase = NULL;
+    segmentBytes = 0;
+
+    ringEvents = NULL;
+    ringCapacity = 0;
+    writeCount = 0;
+}
+
+
+// Destructor.
+SharedMemoryFIFO::~SharedMemoryFIFO()
+{
+    closeSegment();
+}
+
+
+// Segment management. This creates (or replaces) a named segment.
+bool SharedMemoryFIFO::createSegment(const char *newName, int64 eventCapacity)
+{
+    closeSegment();
+
+#if TTLTOOLSSHM_HAVE_POSIX
+    // Round up to a power of 2, so that slot indices are a mask.
+    int64 newCapacity = 2;
+    while (newCapacity < eventCapacity)
+        newCapacity *= 2;
+
+    size_t newBytes = SHM_HEADER_BYTES + ((size_t) newCapacity) * SHM_EVENT_BYTES;
+
+    // Replace any existing segment with this name by unlinking it, rather than truncating it, since readers may still
+    // have the old one mapped. They keep the old segment until they close it.
+    shm_unlink(newName);
+    int newFD = shm_open(newName, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (newFD < 0)
+    {
+        L_WARN(".. WARNING - Couldn't create shared memory segment \"" << newName << "\".");
+        return false;
+    }
+
+    void* newBase = MAP_FAILED;
+    if (0 == ftruncate(newFD, (off_t) newBytes))
+        newBase = mmap(NULL, newBytes, PROT_READ | PROT_WRITE, MAP_SHARED, newFD, 0);
+
+    if (MAP_FAILED == newBase)
+    {
+        L_WARN(".. WARNING - Couldn't map shared memory segment \"" << newName << "\".");
+        close(newFD);
+        shm_unlink(newName);
+        return false;
+    }
+
+    segmentName = String(newName);
+    segmentFD = newFD;
+    segmentBase = newBase;
+    segmentBytes = newBytes;
+
+    ringEvents = (SharedMemoryEvent*) (((char*) segmentBase) + SHM_HEADER_BYTES);
+    ringCapacity = newCapacity;
+    writeCount = 0;
+
+    // The segment is zero-filled. Fill in the header, and write the magic number last, so readers only accept it once it's complete.
+    SharedMemoryHeader* header = new (segmentBase) SharedMemoryHeader;
+    header->version = TTLTOOLSSHM_VERSION;
+    header->headerBytes = SHM_HEADER_BYTES;
+    header->eventBytes = SHM_EVENT_BYTES;
+    header->capacity = (uint64) ringCapacity;
+    header->writeCount.store(0, std::memory_order_relaxed);
+    header->readCount.store(0, std::memory_order_relaxed);
+    header->watermark.store(getWatermark(), std::memory_order_relaxed);
+    header->droppedCount.store(0, std::memory_order_relaxed);
+    header->magic.store(TTLTOOLSSHM_MAGIC, std::memory_order_release);
+
+    return true;
+#else
+    L_WARN(".. WARNING - Shared memory segments aren't supported on this platform.");
+    return false;
+#endif
+}
+
+
+// This closes and removes the segment. Readers that still have it mapped keep working until they close it.
+void SharedMemoryFIFO::closeSegment()
+{
+#if TTLTOOLSSHM_HAVE_POSIX
+    if (NULL != segmentBase)
+    {
+        // Only remove the name if it still refers to our segment; another writer may have replaced it since.
+        int nameFD = shm_open(segmentName.toRawUTF8(), O_RDONLY, 0);
+        if (nameFD >= 0)
+        {
+            struct stat ourStat, nameStat;
+            if ( (0 == fstat(segmentFD, &ourStat)) && (0 == fstat(nameFD, &nameStat))
+                && (ourStat.st_dev == nameStat.st_dev) && (ourStat.st_ino == nameStat.st_ino) )
+                shm_unlink(segmentName.toRawUTF8());
+            close(nameFD);
+        }
+
+        munmap(segmentBase, segmentBytes);
+        close(segmentFD);
+    }
+#endif
+
+    segmentFD = -1;
+    segmentBase = NULL;
+    segmentBytes = 0;
+
+    ringEvents = NULL;
+    ringCapacity = 0;
+    writeCount = 0;
+}
+
+
+bool SharedMemoryFIFO::isSegmentOpen()
+{
+    return (NULL != segmentBase);
+}
+
+
+int64 SharedMemoryFIFO::getSegmentCapacity()
+{
+    return ringCapacity;
+}
+
+
+// Input processing. This writes the event to the ring and then publishes it.
+void SharedMemoryFIFO::handleInput(int64 inputTime, bool inputLevel, int inputTag)
+{
+    if (NULL == segmentBase)
+        overloadCount++;
+    else
+    {
+        SharedMemoryHeader* header = getHeader(segmentBase);
+
+        if ((writeCount - (int64) header->readCount.load(std::memory_order_acquire)) >= ringCapacity)
+        {
+            overloadCount++;
+            header->droppedCount.store(header->droppedCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+        else
+        {
+            SharedMemoryEvent &thisEvent = ringEvents[writeCount & (ringCapacity - 1)];
+            thisEvent.time = inputTime;
+            thisEvent.tag = inputTag;
+            thisEvent.level = (inputLevel ? 1 : 0);
+
+            writeCount++;
+            header->writeCount.store((uint64) writeCount, std::memory_order_release);
+        }
+    }
+
+    // Update the "last input seen" record.
+    setPrevInput(inputTime, inputLevel, inputTag);
+
+    // More input may arrive with this timestamp, but not before it.
+    advanceWatermark(inputTime - 1);
+    publishWatermark();
+}
+
+
+// Batch input. This writes as many events as fit, then publishes them with a single counter update.
+void SharedMemoryFIFO::handleInputBatch(const LogicEvent *inputEvents, int eventCount)
+{
+    if (eventCount < 1)
+        return;
+
+    int storeCount = 0;
+
+    if (NULL != segmentBase)
+    {
+        SharedMemoryHeader* header = getHeader(segmentBase);
+
+        int64 freeCount = ringCapacity - (writeCount - (int64) header->readCount.load(std::memory_order_acquire));
+        storeCount = (freeCount < eventCount) ? ((int) freeCount) : eventCount;
+
+        for (int evIdx = 0; evIdx < storeCount; evIdx++)
+        {
+            SharedMemoryEvent &thisEvent = ringEvents[(writeCount + evIdx) & (ringCapacity - 1)];
+            thisEvent.time = inputEvents[evIdx].time;
+            thisEvent.tag = inputEvents[evIdx].tag;
+            thisEvent.level = (inputEvents[evIdx].level ? 1 : 0);
+        }
+
+        writeCount += storeCount;
+        header->writeCount.store((uint64) writeCount, std::memory_order_release);
+
+        if (storeCount < eventCount)
+            header->droppedCount.store(header->droppedCount.load(std::memory_order_relaxed) + (eventCount - storeCount), std::memory_order_relaxed);
+    }
+
+    overloadCount += eventCount - storeCount;
+
+    // Update the "last input seen" record.
+    const LogicEvent &lastEvent = inputEvents[eventCount - 1];
+    setPrevInput(lastEvent.time, lastEvent.level, lastEvent.tag);
+
+    // More input may arrive with the last timestamp, but not before it.
+    advanceWatermark(lastEvent.time - 1);
+    publishWatermark();
+}
+
+
+// Input processing. Input is complete up to and including this timestamp.
+void SharedMemoryFIFO::advanceToTime(int64 newTime)
+{
+    LogicFIFO::advanceToTime(newTime);
+    publishWatermark();
+}
+
+
+// Input processing. This pulls every event up to newTime from the source and publishes it.
+void SharedMemoryFIFO::pullFromFIFOUntil(LogicFIFO *source, int64 newTime)
+{
+    pullAllFromFIFOUntil(source, newTime);
+}
+
+
+// This copies our watermark to the segment header. The watermark is written after the events it covers.
+void SharedMemoryFIFO::publishWatermark()
+{
+    if (NULL != segmentBase)
+        getHeader(segmentBase)->watermark.store(getWatermark(), std::memory_order_release);
+}
+
+
+
+//
+// Reader for a shared memory segment.
+
+
+// Constructor.
+SharedMemoryReader::SharedMemoryReader()
+{
+    segmentFD = -1;
+    segmentBase = NULL;
+    segmentBytes = 0;
+
+    ringEvents = NULL;
+    ringCapacity = 0;
+    readCount = 0;
+}
+
+
+// Destructor.
+SharedMemoryReader::~SharedMemoryReader()
+{
+    closeSegment();
+}
+
+
+// Segment management. This maps an existing segment and checks its header.
+bool SharedMemoryReader::openSegment(const char *segName)
+{
+    closeSegment();
+
+#if TTLTOOLSSHM_HAVE_POSIX
+    int newFD = shm_open(segName, O_RDWR, 0);
+    if (newFD < 0)
+        return false;
+
+    struct stat segStat;
+    void* newBase = MAP_FAILED;
+    size_t newBytes = 0;
+    if ( (0 == fstat(newFD, &segStat)) && (segStat.st_size >= SHM_HEADER_BYTES) )
+    {
+        newBytes = (size_t) segStat.st_size;
+        newBase = mmap(NULL, newBytes, PROT_READ | PROT_WRITE, MAP_SHARED, newFD, 0);
+    }
+
+    if (MAP_FAILED == newBase)
+    {
+        close(newFD);
+        return false;
+    }
+
+    // The magic number is written last, so the rest of the header can only be read after it's been checked.
+    SharedMemoryHeader* header = getHeader(newBase);
+    uint64 newCapacity = 0;
+    bool isOk = (TTLTOOLSSHM_MAGIC == header->magic.load(std::memory_order_acquire));
+    if (isOk)
+        newCapacity = header->capacity;
+    isOk = isOk && (TTLTOOLSSHM_VERSION == header->version);
+    isOk = isOk && (SHM_HEADER_BYTES == header->headerBytes) && (SHM_EVENT_BYTES == header->eventBytes);
+    // The capacity has to be a power of 2 and has to fit in the segment.
+    isOk = isOk && (newCapacity > 0) && (0 == (newCapacity & (newCapacity - 1)));
+    isOk = isOk && (newCapacity <= ((newBytes - SHM_HEADER_BYTES) / SHM_EVENT_BYTES));
+
+    if (!isOk)
+    {
+        L_WARN(".. WARNING - Shared memory segment \"" << segName << "\" has an unrecognized header.");
+        munmap(newBase, newBytes);
+        close(newFD);
+        return false;
+    }
+
+    segmentFD = newFD;
+    segmentBase = newBase;
+    segmentBytes = newBytes;
+
+    ringEvents = (SharedMemoryEvent*) (((char*) segmentBase) + SHM_HEADER_BYTES);
+    ringCapacity = (int64) newCapacity;
+    readCount = (int64) header->readCount.load(std::memory_order_acquire);
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+void SharedMemoryReader::closeSegment()
+{
+#if TTLTOOLSSHM_HAVE_POSIX
+    if (NULL != segmentBase)
+    {
+        munmap(segmentBase, segmentBytes);
+        close(segmentFD);
+    }
+#endif
+
+    segmentFD = -1;
+    segmentBase = NULL;
+    segmentBytes = 0;
+
+    ringEvents = NULL;
+    ringCapacity = 0;
+    readCount = 0;
+}
+
+
+bool SharedMemoryReader::isSegmentOpen()
+{
+    return (NULL != segmentBase);
+}
+
+
+// Reading.
+
+int64 SharedMemoryReader::getAvailableCount()
+{
+    if (NULL == segmentBase)
+        return 0;
+
+    return ((int64) getHeader(segmentBase)->writeCount.load(std::memory_order_acquire)) - readCount;
+}
+
+
+bool SharedMemoryReader::readNextEvent(int64 &eventTime, bool &eventLevel, int &eventTag)
+{
+    if (getAvailableCount() < 1)
+        return false;
+
+    SharedMemoryEvent &thisEvent = ringEvents[readCount & (ringCapacity - 1)];
+    eventTime = thisEvent.time;
+    eventLevel = (0 != thisEvent.level);
+    eventTag = thisEvent.tag;
+
+    releaseEvents(1);
+
+    return true;
+}
+
+
+// In-place reading. This returns the next contiguous run of unread events.
+const SharedMemoryEvent* SharedMemoryReader::peekEvents(int64 &eventCount)
+{
+    eventCount = getAvailableCount();
+    if (eventCount < 1)
+    {
+        eventCount = 0;
+        return NULL;
+    }
+
+    int64 firstSlot = readCount & (ringCapacity - 1);
+    if (eventCount > (ringCapacity - firstSlot))
+        eventCount = ringCapacity - firstSlot;
+
+    return &(ringEvents[firstSlot]);
+}
+
+
+// This hands events back to the writer. Their slots may be overwritten after this.
+void SharedMemoryReader::releaseEvents(int64 eventCount)
+{
+    int64 availCount = getAvailableCount();
+    if (eventCount > availCount)
+        eventCount = availCount;
+    if (eventCount < 1)
+        return;
+
+    readCount += eventCount;
+    getHeader(segmentBase)->readCount.store((uint64) readCount, std::memory_order_release);
+}
+
+
+// Writer state.
+// The watermark is published after the events it covers, so read it before checking for available events.
+
+int64 SharedMemoryReader::getWatermark()
+{
+    if (NULL == segmentBase)
+        return -1;
+
+    return getHeader(segmentBase)->watermark.load(std::memory_order_acquire);
+}
+
+
+int64 SharedMemoryReader::getDroppedCount()
+{
+    if (NULL == segmentBase)
+        return 0;
+
+    return (int64) getHeader(segmentBase)->droppedCount.load(std::memory_order_relaxed);
+}
+
+
+// This is the end of the file.
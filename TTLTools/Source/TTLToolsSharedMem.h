@@ -0,0 +1,130 @@
+#ifndef TTLTOOLS_SHAREDMEM_H_DEFINED
+#define TTLTOOLS_SHAREDMEM_H_DEFINED
+
+// This is intended to be included via "TTLTools.h", rather than included manually.
+
+// Shared memory segments use the POSIX API (shm_open() and mmap()). On other platforms, these classes still exist,
+// but opening a segment always fails.
+#if defined(__unix__) || defined(__APPLE__)
+#define TTLTOOLSSHM_HAVE_POSIX 1
+#else
+#define TTLTOOLSSHM_HAVE_POSIX 0
+#endif
+
+
+// Magic constant: default number of events in a shared memory ring. This is rounded up to a power of 2.
+#define TTLTOOLSSHM_DEFAULT_EVENTS 65536
+
+// Segment header identification. Readers reject segments with a different magic number, version, or event size.
+#define TTLTOOLSSHM_MAGIC 0x534c5454
+#define TTLTOOLSSHM_VERSION 1
+
+// Segment layout. All fields are little-endian on the platforms this is used on; counters are lock-free 64-bit atomics.
+// Byte 0:    uint32 magic, uint32 version, uint32 header bytes (256), uint32 event bytes (16), uint64 ring capacity (power of 2).
+// Byte 64:   uint64 write count. Only the writer changes this, after the events it covers have been written.
+// Byte 128:  uint64 read count. Only the reader changes this, after it's finished with the events it covers.
+// Byte 192:  int64 watermark (no further events at or before this time), uint64 dropped event count.
+// Byte 256:  ring of events. Event N is at slot (N mod capacity): int64 time, int32 tag, int32 level (0 or 1).
+// The magic number is written last when a segment is created, so a reader never sees a partly-initialized header.
+
+
+// Class declarations.
+namespace TTLTools
+{
+	// One event in a shared memory ring. This matches the segment layout above.
+	// NOTE - This should NOT use the "COMMON_LIB" macro; it's entirely inline.
+	class SharedMemoryEvent
+	{
+	public:
+		int64 time;
+		int32 tag;
+		int32 level;
+	};
+
+
+	// FIFO whose output goes to a named shared memory segment, for a reader in another process.
+	// Events passed to handleInput() are written straight to the ring instead of being queued locally.
+	// There's one writer (this object) and one reader; neither ever blocks or takes a lock.
+	// If the ring is full, the new event is discarded and counted as an overload (and in the segment header).
+	class COMMON_LIB SharedMemoryFIFO : public LogicFIFO
+	{
+	public:
+		// Constructor.
+		SharedMemoryFIFO();
+		// Destructor. This closes and removes the segment.
+		~SharedMemoryFIFO() override;
+
+		// Segment management. This creates (or replaces) a segment with the given name, e.g. "/ttl_triggers".
+		// This allocates, so it should be done during setup. This returns false on failure.
+		// Readers that have a replaced segment mapped keep reading the old one until they reopen.
+		bool createSegment(const char *newName, int64 eventCapacity = TTLTOOLSSHM_DEFAULT_EVENTS);
+		void closeSegment();
+		bool isSegmentOpen();
+		int64 getSegmentCapacity();
+
+		// Input processing. Input is published to the segment as it arrives.
+		void handleInput(int64 inputTime, bool inputLevel, int inputTag = 0) override;
+		// Batches are published to the reader all at once.
+		void handleInputBatch(const LogicEvent *inputEvents, int eventCount) override;
+		void advanceToTime(int64 newTime) override;
+		// Unlike the base class version, this forwards every event, since events with the same time may have different tags.
+		void pullFromFIFOUntil(LogicFIFO *source, int64 newTime) override;
+
+	protected:
+		String segmentName;
+		int segmentFD;
+		void* segmentBase;
+		size_t segmentBytes;
+
+		SharedMemoryEvent* ringEvents;
+		int64 ringCapacity;
+		int64 writeCount;
+
+		void publishWatermark();
+	};
+
+
+	// Reader for a shared memory segment written by SharedMemoryFIFO. This is typically used in another process.
+	// Events can be read in place (peekEvents() then releaseEvents()), or copied out one at a time.
+	class COMMON_LIB SharedMemoryReader
+	{
+	public:
+		// Constructor.
+		SharedMemoryReader();
+		// Destructor. This unmaps the segment.
+		~SharedMemoryReader();
+
+		// Segment management. This returns false if the segment doesn't exist or has an incompatible header.
+		bool openSegment(const char *segName);
+		void closeSegment();
+		bool isSegmentOpen();
+
+		// Reading.
+		int64 getAvailableCount();
+		bool readNextEvent(int64 &eventTime, bool &eventLevel, int &eventTag);
+
+		// In-place reading. This returns a pointer to the next run of unread events, and sets the number of events in it.
+		// A run stops at the end of the ring, so call this again after releasing to get any events after the wrap point.
+		// The events stay valid until they're released.
+		const SharedMemoryEvent* peekEvents(int64 &eventCount);
+		void releaseEvents(int64 eventCount);
+
+		// Writer state.
+		int64 getWatermark();
+		int64 getDroppedCount();
+
+	protected:
+		int segmentFD;
+		void* segmentBase;
+		size_t segmentBytes;
+
+		SharedMemoryEvent* ringEvents;
+		int64 ringCapacity;
+		int64 readCount;
+	};
+}
+
+#endif
+
+
+// This is the end of the file.
@@ -0,0 +1,187 @@
+#include "TTLTools.h"
+#define LOGICDEBUGPREFIX "[TTLToolsStats] "
+#define LOGICDEBUGIDVARIABLE debugID
+#include "TTLToolsDebug.h"
+
+using namespace TTLTools;
+
+// Private constants.
+
+// This timestamp could happen, but we need _something_ as the default.
+#define LOGIC_TIMESTAMP_BOGUS (-1)
+
+
+//
+// Pulse statistics pass-through FIFO.
+
+
+// Constructor.
+PulseStatsTap::PulseStatsTap()
+{
+    resetRequested.set(0);
+    emptyLineStats.clear();
+
+    resetStats();
+}
+
+
+// This clears the statistics. It should be called from the processing thread.
+void PulseStatsTap::resetStats()
+{
+    runningStats.lineCount = 0;
+    runningStats.processedTime = LOGIC_TIMESTAMP_BOGUS;
+
+    for (int lineIdx = 0; lineIdx < TTLTOOLSSTATS_MAX_LINES; lineIdx++)
+    {
+        runningStats.lineStats[lineIdx].clear();
+
+        lineLevels[lineIdx] = false;
+        lineLevelKnown[lineIdx] = false;
+        lastRiseTimes[lineIdx] = LOGIC_TIMESTAMP_BOGUS;
+        lastFallTimes[lineIdx] = LOGIC_TIMESTAMP_BOGUS;
+    }
+}
+
+
+// This can be called from any thread.
+void PulseStatsTap::requestReset()
+{
+    resetRequested.set(1);
+}
+
+
+// Setup. This also clears the statistics.
+void PulseStatsTap::clearBuffer()
+{
+    LogicFIFO::clearBuffer();
+    resetStats();
+}
+
+
+// Input processing. Events are passed through and measured.
+void PulseStatsTap::handleInput(int64 inputTime, bool inputLevel, int inputTag)
+{
+    LogicFIFO::handleInput(inputTime, inputLevel, inputTag);
+    measureEvent(inputTime, inputLevel, inputTag);
+}
+
+
+void PulseStatsTap::handleInputBatch(const LogicEvent *inputEvents, int eventCount)
+{
+    copyInputBatch(inputEvents, eventCount);
+
+    for (int evIdx = 0; evIdx < eventCount; evIdx++)
+        measureEvent(inputEvents[evIdx].time, inputEvents[evIdx].level, inputEvents[evIdx].tag);
+}
+
+
+// Input processing. Input is complete up to and including this timestamp, so this is a good time to publish.
+void PulseStatsTap::advanceToTime(int64 newTime)
+{
+    if (0 != resetRequested.exchange(0))
+        resetStats();
+
+    LogicFIFO::advanceToTime(newTime);
+
+    if (newTime > runningStats.processedTime)
+        runningStats.processedTime = newTime;
+
+    publishStats();
+}
+
+
+void PulseStatsTap::pullFromFIFOUntil(LogicFIFO *source, int64 newTime)
+{
+    pullAllFromFIFOUntil(source, newTime);
+}
+
+
+// Processing thread access to the running statistics.
+
+const PulseLineStats &PulseStatsTap::getLineStats(int lineIdx)
+{
+    if ( (lineIdx < 0) || (lineIdx >= runningStats.lineCount) )
+        return emptyLineStats;
+
+    return runningStats.lineStats[lineIdx];
+}
+
+
+int PulseStatsTap::getLineCount()
+{
+    return runningStats.lineCount;
+}
+
+
+// Reader side.
+
+bool PulseStatsTap::fetchSnapshot()
+{
+    return snapshotBuffer.fetchLatest();
+}
+
+
+const PulseStatsSnapshot &PulseStatsTap::getSnapshot()
+{
+    return snapshotBuffer.getReadSlot();
+}
+
+
+// This updates the line's edge state, and adds any durations that this edge completes.
+void PulseStatsTap::measureEvent(int64 inputTime, bool inputLevel, int inputTag)
+{
+    if ( (inputTag < 0) || (inputTag >= TTLTOOLSSTATS_MAX_LINES) )
+        return;
+
+    if (!lineLevelKnown[inputTag])
+    {
+        lineLevelKnown[inputTag] = true;
+        lineLevels[inputTag] = inputLevel;
+
+        if (inputTag >= runningStats.lineCount)
+            runningStats.lineCount = inputTag + 1;
+
+        return;
+    }
+
+    if (inputLevel == lineLevels[inputTag])
+        return;
+
+    lineLevels[inputTag] = inputLevel;
+    PulseLineStats &thisLine = runningStats.lineStats[inputTag];
+
+    if (inputLevel)
+    {
+        if (LOGIC_TIMESTAMP_BOGUS != lastFallTimes[inputTag])
+            thisLine.lowTime.addValue(inputTime - lastFallTimes[inputTag]);
+        if (LOGIC_TIMESTAMP_BOGUS != lastRiseTimes[inputTag])
+            thisLine.period.addValue(inputTime - lastRiseTimes[inputTag]);
+
+        lastRiseTimes[inputTag] = inputTime;
+    }
+    else
+    {
+        if (LOGIC_TIMESTAMP_BOGUS != lastRiseTimes[inputTag])
+            thisLine.highTime.addValue(inputTime - lastRiseTimes[inputTag]);
+
+        lastFallTimes[inputTag] = inputTime;
+    }
+}
+
+
+// This copies the lines measured so far to the triple buffer's write slot and publishes them.
+void PulseStatsTap::publishStats()
+{
+    PulseStatsSnapshot &destSnapshot = snapshotBuffer.getWriteSlot();
+
+    destSnapshot.lineCount = runningStats.lineCount;
+    destSnapshot.processedTime = runningStats.processedTime;
+
+    for (int lineIdx = 0; lineIdx < runningStats.lineCount; lineIdx++)
+        destSnapshot.lineStats[lineIdx] = runningStats.lineStats[lineIdx];
+
+    snapshotBuffer.publish();
+}
+
+
+// This is the end of the file.
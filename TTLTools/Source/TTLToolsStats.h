@@ -0,0 +1,186 @@
+#ifndef TTLTOOLS_STATS_H_DEFINED
+#define TTLTOOLS_STATS_H_DEFINED
+
+// This is intended to be included via "TTLTools.h", rather than included manually.
+
+
+// Magic constant: maximum number of lines (tags) measured. Events with other tags are passed through but not measured.
+#define TTLTOOLSSTATS_MAX_LINES 16
+
+// Number of histogram buckets. Bucket N counts durations with a bit length of N (0, 1, 2-3, 4-7, ...).
+#define TTLTOOLSSTATS_HIST_BUCKETS 64
+
+
+// Class declarations.
+namespace TTLTools
+{
+	// Running statistics for one kind of duration (in samples).
+	// Mean and variance use Welford's method, so they stay accurate over long runs.
+	// Nothing in here is dynamically allocated, so copy-by-value is fine.
+	// NOTE - This should NOT use the "COMMON_LIB" macro; it's entirely inline.
+	class DurationStats
+	{
+	public:
+		int64 count;
+		int64 minValue;
+		int64 maxValue;
+		double meanValue;
+		double sumSquaredDiffs;
+		int64 histogram[TTLTOOLSSTATS_HIST_BUCKETS];
+
+		// Constructor.
+		DurationStats()
+		{
+			clear();
+		}
+
+		void clear()
+		{
+			count = 0;
+			minValue = 0;
+			maxValue = 0;
+			meanValue = 0;
+			sumSquaredDiffs = 0;
+			for (int bucketIdx = 0; bucketIdx < TTLTOOLSSTATS_HIST_BUCKETS; bucketIdx++)
+				histogram[bucketIdx] = 0;
+		}
+
+		void addValue(int64 newValue)
+		{
+			if ( (0 == count) || (newValue < minValue) )
+				minValue = newValue;
+			if ( (0 == count) || (newValue > maxValue) )
+				maxValue = newValue;
+
+			count++;
+			double valueDelta = ((double) newValue) - meanValue;
+			meanValue += valueDelta / (double) count;
+			sumSquaredDiffs += valueDelta * (((double) newValue) - meanValue);
+
+			histogram[getBucketIndex(newValue)]++;
+		}
+
+		// Sample variance. This is zero until there are at least two values.
+		double getVariance() const
+		{
+			return (count > 1) ? (sumSquaredDiffs / (double) (count - 1)) : 0;
+		}
+
+		// This returns the bit length of the value, by binary search. Negative values go in bucket 0.
+		static int getBucketIndex(int64 thisValue)
+		{
+			if (thisValue <= 0)
+				return 0;
+
+			uint64 bitsLeft = (uint64) thisValue;
+			int bucketIdx = 0;
+			for (int shiftBits = 32; shiftBits > 0; shiftBits /= 2)
+				if (0 != (bitsLeft >> shiftBits))
+				{
+					bitsLeft >>= shiftBits;
+					bucketIdx += shiftBits;
+				}
+
+			return bucketIdx + (int) bitsLeft;
+		}
+	};
+
+
+	// Pulse statistics for one line: high time, low time, and period (rising edge to rising edge).
+	// NOTE - This should NOT use the "COMMON_LIB" macro; it's entirely inline.
+	class PulseLineStats
+	{
+	public:
+		DurationStats highTime;
+		DurationStats lowTime;
+		DurationStats period;
+
+		void clear()
+		{
+			highTime.clear();
+			lowTime.clear();
+			period.clear();
+		}
+	};
+
+
+	// Snapshot of all measured lines, for reading on another thread.
+	// NOTE - This should NOT use the "COMMON_LIB" macro; it's entirely inline.
+	class PulseStatsSnapshot
+	{
+	public:
+		// Lines are 0..(lineCount-1); this is one more than the highest tag measured so far.
+		int lineCount;
+		// Time up to which input was processed.
+		int64 processedTime;
+		PulseLineStats lineStats[TTLTOOLSSTATS_MAX_LINES];
+
+		// Constructor.
+		PulseStatsSnapshot()
+		{
+			lineCount = 0;
+			processedTime = -1;
+		}
+	};
+
+
+	// Pass-through FIFO that measures pulse statistics for each line (event tag) going through it.
+	// Feed it with handleInput() or pullFromFIFOUntil() and read its output as usual, or just discard its output.
+	// Repeated events with the same level aren't edges, and are passed through without being measured. The first
+	// event on each line only sets the line's level, since we don't know what the level was before it.
+	// Updates are O(1) per event and don't allocate. Statistics are published once per advanceToTime() call, through a
+	// triple buffer, so one other thread can read them without locking.
+	// NOTE - This is large (several copies of the statistics). Allocate it on the heap.
+	class COMMON_LIB PulseStatsTap : public LogicFIFO
+	{
+	public:
+		// Constructor.
+		PulseStatsTap();
+		// Default destructor is fine.
+
+		// This clears the statistics. It should be called from the processing thread.
+		void resetStats();
+		// This can be called from any thread. The reset happens at the start of the next advanceToTime() call.
+		void requestReset();
+
+		// Setup. This also clears the statistics.
+		void clearBuffer() override;
+
+		// Input processing.
+		void handleInput(int64 inputTime, bool inputLevel, int inputTag = 0) override;
+		void handleInputBatch(const LogicEvent *inputEvents, int eventCount) override;
+		// This publishes a snapshot of the statistics.
+		void advanceToTime(int64 newTime) override;
+		// Unlike the base class version, this forwards every event, since events with the same time may have different tags.
+		void pullFromFIFOUntil(LogicFIFO *source, int64 newTime) override;
+
+		// Processing thread access to the running statistics. Out-of-range lines return empty statistics.
+		const PulseLineStats &getLineStats(int lineIdx);
+		int getLineCount();
+
+		// Reader side. fetchSnapshot() returns true if new statistics were published since the last fetch.
+		// NOTE - Only one thread may read snapshots.
+		bool fetchSnapshot();
+		const PulseStatsSnapshot &getSnapshot();
+
+	protected:
+		PulseStatsSnapshot runningStats;
+		TripleBuffer<PulseStatsSnapshot> snapshotBuffer;
+		Atomic<int> resetRequested;
+		PulseLineStats emptyLineStats;
+
+		// Per-line edge state. Edge times are bogus until that edge has been seen.
+		bool lineLevels[TTLTOOLSSTATS_MAX_LINES];
+		bool lineLevelKnown[TTLTOOLSSTATS_MAX_LINES];
+		int64 lastRiseTimes[TTLTOOLSSTATS_MAX_LINES];
+		int64 lastFallTimes[TTLTOOLSSTATS_MAX_LINES];
+
+		void measureEvent(int64 inputTime, bool inputLevel, int inputTag);
+		void publishStats();
+	};
+}
+
+#endif
+
+
+// This is the end of the file.
@@ -0,0 +1,413 @@
+#include "TTLTools.h"
+#define LOGICDEBUGPREFIX "[TTLToolsSynth] "
+#define LOGICDEBUGIDVARIABLE debugID
+#include "TTLToolsDebug.h"
+
+using namespace TTLTools;
+
+// Private constants.
+
+// This timestamp could happen, but we need _something_ as the default.
+#define LOGIC_TIMESTAMP_BOGUS (-1)
+
+// Checkpoint section identifier.
+#define LOGIC_STATE_MAGIC_SYNTH 0x544e5953
+
+// Checkpointed bytes per line: configuration, then generator state.
+#define SYNTH_STATE_LINE_BYTES (4 + 8 + 8 + 4 + 8 + 8 + 8 + 4 + 4*8 + 4 + 4 + 4 + 8 + 4)
+
+
+//
+// Configuration for one synthetic TTL line.
+
+
+// Constructor.
+SyntheticLineConfig::SyntheticLineConfig()
+{
+    // Initialize to safe defaults.
+    clear();
+}
+
+
+// This sets a known-sane configuration state.
+void SyntheticLineConfig::clear()
+{
+    pattern = SyntheticLineConfig::patternPeriodic;
+
+    periodSamps = 3000;
+    pulseWidthSamps = 300;
+
+    burstPulses = 5;
+    burstGapSamps = 30000;
+
+    glitchProbability = 0;
+    glitchWidthSamps = 1;
+
+    tag = 0;
+}
+
+
+// This forces configuration parameters to be valid and self-consistent.
+void SyntheticLineConfig::forceSanity()
+{
+    switch (pattern)
+    {
+    case SyntheticLineConfig::patternPoisson: break;
+    case SyntheticLineConfig::patternBursty: break;
+    default:
+        pattern = SyntheticLineConfig::patternPeriodic;
+        break;
+    }
+
+    if (pulseWidthSamps < 1)
+        pulseWidthSamps = 1;
+
+    // Pulses can't overlap.
+    if (periodSamps <= pulseWidthSamps)
+        periodSamps = pulseWidthSamps + 1;
+
+    if (burstPulses < 1)
+        burstPulses = 1;
+    if (burstGapSamps < 0)
+        burstGapSamps = 0;
+
+    if (glitchProbability < 0)
+        glitchProbability = 0;
+    if (glitchProbability > 1)
+        glitchProbability = 1;
+
+    if (glitchWidthSamps < 1)
+        glitchWidthSamps = 1;
+}
+
+
+
+//
+// Synthetic TTL event source.
+
+
+// Constructor.
+SyntheticSource::SyntheticSource()
+{
+    generatedCount = 0;
+    clearLines();
+}
+
+
+// Configuration.
+
+void SyntheticSource::clearLines()
+{
+    lineCount = 0;
+    restartAt(0);
+}
+
+
+// This returns the line index, or -1 if there are too many lines.
+int SyntheticSource::addLine(SyntheticLineConfig &newConfig)
+{
+    if (lineCount >= TTLTOOLSSYNTH_MAX_LINES)
+    {
+        L_WARN(".. WARNING - Too many synthetic lines (limit is " << TTLTOOLSSYNTH_MAX_LINES << ").");
+        return -1;
+    }
+
+    int lineIdx = lineCount;
+    lineConfigs[lineIdx] = newConfig;
+    lineConfigs[lineIdx].forceSanity();
+    lineCount++;
+
+    // Start this line where the other lines' generation currently is.
+    restartAt(getWatermark() + 1);
+
+    return lineIdx;
+}
+
+
+int SyntheticSource::getLineCount()
+{
+    return lineCount;
+}
+
+
+void SyntheticSource::setSeed(int64 newSeed)
+{
+    rng.setSeed(newSeed);
+}
+
+
+// This discards queued output and restarts all lines at the specified time, with random phase.
+void SyntheticSource::restartAt(int64 startTime)
+{
+    clearBuffer();
+    setPrevInput(startTime - 1, false);
+    advanceWatermark(startTime - 1);
+
+    for (int lineIdx = 0; lineIdx < lineCount; lineIdx++)
+    {
+        int64 thisPeriod = lineConfigs[lineIdx].periodSamps;
+        nextPulseTime[lineIdx] = startTime + ( ((int64) rng.nextInt(0x7fffffff)) % thisPeriod );
+        burstPosition[lineIdx] = 0;
+        buildNextPulse(lineIdx);
+    }
+}
+
+
+// Generation. This queues all events up to and including the specified time.
+void SyntheticSource::generateUntil(int64 newTime)
+{
+    bool hadEvent = (lineCount > 0);
+
+    while (hadEvent)
+    {
+        // Find the line with the earliest pending edge. Ties go to the lowest-numbered line.
+        int bestLine = 0;
+        int64 bestTime = pulseEdgeTimes[0][pulseEdgeIdx[0]];
+        for (int lineIdx = 1; lineIdx < lineCount; lineIdx++)
+        {
+            int64 thisTime = pulseEdgeTimes[lineIdx][pulseEdgeIdx[lineIdx]];
+            if (thisTime < bestTime)
+            {
+                bestTime = thisTime;
+                bestLine = lineIdx;
+            }
+        }
+
+        hadEvent = (bestTime <= newTime);
+        if (hadEvent)
+        {
+            int edgeIdx = pulseEdgeIdx[bestLine];
+            LogicFIFO::handleInput(bestTime, pulseEdgeLevels[bestLine][edgeIdx], lineConfigs[bestLine].tag);
+            generatedCount++;
+
+            edgeIdx++;
+            if (edgeIdx < pulseEdgeCount[bestLine])
+                pulseEdgeIdx[bestLine] = edgeIdx;
+            else
+                buildNextPulse(bestLine);
+        }
+    }
+
+    LogicFIFO::advanceToTime(newTime);
+}
+
+
+// For compatibility with other sources, advancing time generates events.
+void SyntheticSource::advanceToTime(int64 newTime)
+{
+    generateUntil(newTime);
+}
+
+
+// We're never fed externally, so consumers pulling from us get events generated on demand.
+// This returns false once we've generated everything up to untilTime.
+bool SyntheticSource::pullMoreOutput(int64 untilTime)
+{
+    if (getWatermark() >= untilTime)
+        return false;
+
+    generateUntil(untilTime);
+    return true;
+}
+
+
+// Statistics.
+
+int64 SyntheticSource::getGeneratedCount()
+{
+    return generatedCount;
+}
+
+
+// Checkpointing.
+
+void SyntheticSource::writeState(MemoryOutputStream &dest)
+{
+    dest.writeInt(LOGIC_STATE_MAGIC_SYNTH);
+
+    dest.writeInt64(rng.getSeed());
+    dest.writeInt64(generatedCount);
+
+    dest.writeInt(lineCount);
+    for (int lineIdx = 0; lineIdx < lineCount; lineIdx++)
+    {
+        SyntheticLineConfig &thisConfig = lineConfigs[lineIdx];
+        dest.writeInt((int) thisConfig.pattern);
+        dest.writeInt64(thisConfig.periodSamps);
+        dest.writeInt64(thisConfig.pulseWidthSamps);
+        dest.writeInt(thisConfig.burstPulses);
+        dest.writeInt64(thisConfig.burstGapSamps);
+        dest.writeDouble(thisConfig.glitchProbability);
+        dest.writeInt64(thisConfig.glitchWidthSamps);
+        dest.writeInt(thisConfig.tag);
+
+        for (int edgeIdx = 0; edgeIdx < 4; edgeIdx++)
+            dest.writeInt64(pulseEdgeTimes[lineIdx][edgeIdx]);
+        // Edge levels are packed into one int.
+        int levelBits = 0;
+        for (int edgeIdx = 0; edgeIdx < 4; edgeIdx++)
+            if (pulseEdgeLevels[lineIdx][edgeIdx])
+                levelBits |= (1 << edgeIdx);
+        dest.writeInt(levelBits);
+        dest.writeInt(pulseEdgeCount[lineIdx]);
+        dest.writeInt(pulseEdgeIdx[lineIdx]);
+        dest.writeInt64(nextPulseTime[lineIdx]);
+        dest.writeInt(burstPosition[lineIdx]);
+    }
+
+    LogicFIFO::writeState(dest);
+}
+
+
+bool SyntheticSource::readState(MemoryInputStream &source)
+{
+    // Magic number, seed, generated count, and line count.
+    if (source.getNumBytesRemaining() < (4 + 8 + 8 + 4))
+        return false;
+    if (LOGIC_STATE_MAGIC_SYNTH != source.readInt())
+        return false;
+
+    int64 newSeed = source.readInt64();
+    int64 newGeneratedCount = source.readInt64();
+
+    int newLineCount = source.readInt();
+    if ( (newLineCount < 0) || (newLineCount > TTLTOOLSSYNTH_MAX_LINES)
+        || (source.getNumBytesRemaining() < SYNTH_STATE_LINE_BYTES * (int64) newLineCount) )
+        return false;
+
+    // Stage the lines, so that a failed restore doesn't overwrite anything.
+    Array<SyntheticLineConfig> newConfigs;
+    Array<int64> newEdgeTimes;
+    Array<int> newLevelBits;
+    Array<int> newEdgeCounts;
+    Array<int> newEdgeIndices;
+    Array<int64> newPulseTimes;
+    Array<int> newBurstPositions;
+    for (int lineIdx = 0; lineIdx < newLineCount; lineIdx++)
+    {
+        SyntheticLineConfig thisConfig;
+        thisConfig.pattern = (SyntheticLineConfig::PatternType) source.readInt();
+        thisConfig.periodSamps = source.readInt64();
+        thisConfig.pulseWidthSamps = source.readInt64();
+        thisConfig.burstPulses = source.readInt();
+        thisConfig.burstGapSamps = source.readInt64();
+        thisConfig.glitchProbability = source.readDouble();
+        thisConfig.glitchWidthSamps = source.readInt64();
+        thisConfig.tag = source.readInt();
+        thisConfig.forceSanity();
+        newConfigs.add(thisConfig);
+
+        for (int edgeIdx = 0; edgeIdx < 4; edgeIdx++)
+            newEdgeTimes.add(source.readInt64());
+        newLevelBits.add(source.readInt());
+
+        int thisEdgeCount = source.readInt();
+        int thisEdgeIdx = source.readInt();
+        if ( (thisEdgeCount < 1) || (thisEdgeCount > 4) || (thisEdgeIdx < 0) || (thisEdgeIdx >= thisEdgeCount) )
+            return false;
+        newEdgeCounts.add(thisEdgeCount);
+        newEdgeIndices.add(thisEdgeIdx);
+
+        newPulseTimes.add(source.readInt64());
+        newBurstPositions.add(source.readInt());
+    }
+
+    if (!LogicFIFO::readState(source))
+        return false;
+
+    lineCount = newLineCount;
+    for (int lineIdx = 0; lineIdx < lineCount; lineIdx++)
+    {
+        lineConfigs[lineIdx] = newConfigs[lineIdx];
+
+        for (int edgeIdx = 0; edgeIdx < 4; edgeIdx++)
+        {
+            pulseEdgeTimes[lineIdx][edgeIdx] = newEdgeTimes[lineIdx * 4 + edgeIdx];
+            pulseEdgeLevels[lineIdx][edgeIdx] = ( 0 != (newLevelBits[lineIdx] & (1 << edgeIdx)) );
+        }
+        pulseEdgeCount[lineIdx] = newEdgeCounts[lineIdx];
+        pulseEdgeIdx[lineIdx] = newEdgeIndices[lineIdx];
+        nextPulseTime[lineIdx] = newPulseTimes[lineIdx];
+        burstPosition[lineIdx] = newBurstPositions[lineIdx];
+    }
+
+    rng.setSeed(newSeed);
+    generatedCount = newGeneratedCount;
+
+    return true;
+}
+
+
+// Protected accessors.
+
+// This builds the edge list for a line's next pulse.
+void SyntheticSource::buildNextPulse(int lineIdx)
+{
+    SyntheticLineConfig &thisConfig = lineConfigs[lineIdx];
+    int64 riseTime = nextPulseTime[lineIdx];
+    int64 fallTime = riseTime + thisConfig.pulseWidthSamps;
+    int edgeCount = 0;
+
+    pulseEdgeTimes[lineIdx][edgeCount] = riseTime;
+    pulseEdgeLevels[lineIdx][edgeCount] = true;
+    edgeCount++;
+
+    // Glitches only fit if the pulse is wide enough to hold them without touching either edge.
+    int64 glitchRoom = thisConfig.pulseWidthSamps - thisConfig.glitchWidthSamps - 1;
+    if ( (glitchRoom > 0) && (rng.nextDouble() < thisConfig.glitchProbability) )
+    {
+        int64 glitchTime = riseTime + 1 + ( ((int64) rng.nextInt(0x7fffffff)) % glitchRoom );
+
+        pulseEdgeTimes[lineIdx][edgeCount] = glitchTime;
+        pulseEdgeLevels[lineIdx][edgeCount] = false;
+        edgeCount++;
+
+        pulseEdgeTimes[lineIdx][edgeCount] = glitchTime + thisConfig.glitchWidthSamps;
+        pulseEdgeLevels[lineIdx][edgeCount] = true;
+        edgeCount++;
+    }
+
+    pulseEdgeTimes[lineIdx][edgeCount] = fallTime;
+    pulseEdgeLevels[lineIdx][edgeCount] = false;
+    edgeCount++;
+
+    pulseEdgeCount[lineIdx] = edgeCount;
+    pulseEdgeIdx[lineIdx] = 0;
+
+    // Pulses can't overlap, so the next one starts after this one ends.
+    int64 nextTime = riseTime + drawInterval(lineIdx);
+    if (nextTime <= fallTime)
+        nextTime = fallTime + 1;
+    nextPulseTime[lineIdx] = nextTime;
+}
+
+
+// This draws the spacing to the following pulse according to the line's pattern.
+int64 SyntheticSource::drawInterval(int lineIdx)
+{
+    SyntheticLineConfig &thisConfig = lineConfigs[lineIdx];
+    int64 thisInterval = thisConfig.periodSamps;
+
+    switch (thisConfig.pattern)
+    {
+    case SyntheticLineConfig::patternPoisson:
+        // Exponentially distributed spacing. Use (1 - u) so that we never take the log of zero.
+        thisInterval = (int64) (-std::log(1.0 - rng.nextDouble()) * (double) thisConfig.periodSamps);
+        break;
+    case SyntheticLineConfig::patternBursty:
+        burstPosition[lineIdx]++;
+        if (burstPosition[lineIdx] >= thisConfig.burstPulses)
+        {
+            burstPosition[lineIdx] = 0;
+            thisInterval += thisConfig.burstGapSamps;
+        }
+        break;
+    default:
+        break;
+    }
+
+    return thisInterval;
+}
+
+
+// This is the end of the file.
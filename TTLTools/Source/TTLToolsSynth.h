@@ -0,0 +1,112 @@
+#ifndef TTLTOOLS_SYNTH_H_DEFINED
+#define TTLTOOLS_SYNTH_H_DEFINED
+
+// This is intended to be included via "TTLTools.h", rather than included manually.
+
+
+// Magic constant: maximum number of lines a synthetic source can generate.
+#define TTLTOOLSSYNTH_MAX_LINES 64
+
+
+// Class declarations.
+namespace TTLTools
+{
+	// Configuration for one synthetic TTL line.
+	// Nothing in here is dynamically allocated, so copy-by-value is fine.
+	class COMMON_LIB SyntheticLineConfig
+	{
+	public:
+		enum PatternType
+		{
+			patternPeriodic = 0,
+			patternPoisson = 1,
+			patternBursty = 2
+		};
+
+		// Configuration parameters. External editing is fine.
+		PatternType pattern;
+		// Mean spacing between pulse rising edges (exact spacing for periodic patterns).
+		int64 periodSamps;
+		int64 pulseWidthSamps;
+		// Bursts have this many pulses at the normal period, followed by a gap (in addition to the normal period).
+		int burstPulses;
+		int64 burstGapSamps;
+		// Probability (0..1) of inserting a glitch pair (short pulse of the opposite level) inside any given pulse.
+		double glitchProbability;
+		int64 glitchWidthSamps;
+		// Tag to attach to this line's events.
+		int tag;
+
+		// Constructor.
+		SyntheticLineConfig();
+		// Default destructor is fine.
+
+		// This sets a known-sane configuration state.
+		void clear();
+		// This forces configuration parameters to be valid and self-consistent.
+		void forceSanity();
+	};
+
+
+	// Synthetic TTL event source, for load testing.
+	// This generates edge streams on demand, for one or more lines, and queues them as output events in time order.
+	// It can be used as a merger input or as a pullFromFIFOUntil() source, the same way as real input FIFOs.
+	class COMMON_LIB SyntheticSource : public LogicFIFO
+	{
+	public:
+		// Constructor.
+		SyntheticSource();
+		// Default destructor is fine.
+
+		// Configuration. Changing configuration restarts generation at the specified time.
+		void clearLines();
+		// This returns the line index, or -1 if there are too many lines.
+		int addLine(SyntheticLineConfig &newConfig);
+		int getLineCount();
+		void setSeed(int64 newSeed);
+		void restartAt(int64 startTime);
+
+		// Generation. This queues all events up to and including the specified time, and advances the watermark.
+		// NOTE - Events that don't fit in the output buffer are discarded, as with any other FIFO.
+		void generateUntil(int64 newTime);
+		// For compatibility with other sources, advancing time generates events.
+		void advanceToTime(int64 newTime) override;
+		// Lazy pulling generates events too, so this can be at the top of a pulled pipeline without being advanced by hand.
+		bool pullMoreOutput(int64 untilTime) override;
+
+		// Statistics.
+		int64 getGeneratedCount();
+
+		// Checkpointing. This saves the line configurations and random number generator state as well as generator state,
+		// so a restored source produces the same events that the saved one would have.
+		void writeState(MemoryOutputStream &dest) override;
+		bool readState(MemoryInputStream &source) override;
+
+	protected:
+		Random rng;
+
+		SyntheticLineConfig lineConfigs[TTLTOOLSSYNTH_MAX_LINES];
+		int lineCount;
+
+		// Per-line generator state.
+		// Each pulse is built as a short list of edges: rising, an optional glitch pair, and falling.
+		int64 pulseEdgeTimes[TTLTOOLSSYNTH_MAX_LINES][4];
+		bool pulseEdgeLevels[TTLTOOLSSYNTH_MAX_LINES][4];
+		int pulseEdgeCount[TTLTOOLSSYNTH_MAX_LINES];
+		int pulseEdgeIdx[TTLTOOLSSYNTH_MAX_LINES];
+		int64 nextPulseTime[TTLTOOLSSYNTH_MAX_LINES];
+		int burstPosition[TTLTOOLSSYNTH_MAX_LINES];
+
+		int64 generatedCount;
+
+		// This builds the edge list for a line's next pulse.
+		void buildNextPulse(int lineIdx);
+		// This draws the spacing to the following pulse according to the line's pattern.
+		int64 drawInterval(int lineIdx);
+	};
+}
+
+#endif
+
+
+// This is the end of the file.
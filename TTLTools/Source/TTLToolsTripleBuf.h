@@ -0,0 +1,118 @@
+#ifndef TTLTOOLS_TRIPLEBUF_H_DEFINED
+#define TTLTOOLS_TRIPLEBUF_H_DEFINED
+
+#include <CommonLibHeader.h>
+
+
+//
+// Triple buffer helper class - Declaration.
+
+// This passes the most recent value of something from one writer thread to one reader thread without locking.
+// The writer fills its private slot and publishes it; the reader fetches the newest published slot when it wants to.
+// Neither side ever waits for the other. Values published between fetches are skipped, not queued.
+// NOTE - This is only safe with exactly one writer thread and one reader thread.
+
+namespace TTLTools
+{
+	// NOTE - This should NOT use the "COMMON_LIB" macro.
+	// That's for object code that's linked from shared libraries. Template instances rebuild the object code rather than importing it.
+	template <class datatype_t> class TripleBuffer
+	{
+	public:
+		TripleBuffer();
+
+		// Writer side. Either fill getWriteSlot() and call publish(), or call publish() with a value.
+		datatype_t &getWriteSlot();
+		void publish();
+		void publish(const datatype_t &newVal);
+
+		// Reader side. fetchLatest() returns true if a new value was published since the last fetch.
+		bool hasNewData();
+		bool fetchLatest();
+		datatype_t &getReadSlot();
+
+	protected:
+		datatype_t slotData[3];
+		int writeIdx, readIdx;
+		// The middle slot index, plus a flag that's set if it holds data the reader hasn't seen yet.
+		Atomic<int> middleState;
+	};
+}
+
+
+
+//
+// Triple buffer helper class - Implementation.
+
+
+// Flag bit marking the middle slot as freshly published.
+#define TTLTOOLS_TRIPLEBUF_FRESH 4
+#define TTLTOOLS_TRIPLEBUF_INDEX_MASK 3
+
+
+template <class datatype_t>
+TTLTools::TripleBuffer<datatype_t>::TripleBuffer()
+{
+	writeIdx = 0;
+	readIdx = 1;
+	middleState.set(2);
+}
+
+
+template <class datatype_t>
+datatype_t &TTLTools::TripleBuffer<datatype_t>::getWriteSlot()
+{
+	return slotData[writeIdx];
+}
+
+
+template <class datatype_t>
+void TTLTools::TripleBuffer<datatype_t>::publish()
+{
+	// Swap our slot into the middle, and take whatever was there (stale or unread) as our next slot.
+	int prevState = middleState.exchange(writeIdx | TTLTOOLS_TRIPLEBUF_FRESH);
+	writeIdx = prevState & TTLTOOLS_TRIPLEBUF_INDEX_MASK;
+}
+
+
+template <class datatype_t>
+void TTLTools::TripleBuffer<datatype_t>::publish(const datatype_t &newVal)
+{
+	slotData[writeIdx] = newVal;
+	publish();
+}
+
+
+template <class datatype_t>
+bool TTLTools::TripleBuffer<datatype_t>::hasNewData()
+{
+	return ( 0 != (middleState.get() & TTLTOOLS_TRIPLEBUF_FRESH) );
+}
+
+
+template <class datatype_t>
+bool TTLTools::TripleBuffer<datatype_t>::fetchLatest()
+{
+	// Only the writer sets the flag, so if it's clear now, there's nothing to fetch.
+	if (!hasNewData())
+		return false;
+
+	// Swap our slot into the middle (marked as already read), and take the freshly published slot.
+	int prevState = middleState.exchange(readIdx);
+	readIdx = prevState & TTLTOOLS_TRIPLEBUF_INDEX_MASK;
+
+	return true;
+}
+
+
+template <class datatype_t>
+datatype_t &TTLTools::TripleBuffer<datatype_t>::getReadSlot()
+{
+	return slotData[readIdx];
+}
+
+
+#endif
+
+//
+// This is the end of the file.